@@ -0,0 +1,93 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "json_parser.h"
+#include "order_book.h"
+
+#define ANALYTICS_MAX_SYMBOLS 256
+#define ANALYTICS_SYMBOL_SIZE 24
+#define ANALYTICS_WINDOW_INITIAL_CAPACITY 1024   // trades per symbol before the ring grows, power of two
+#define ANALYTICS_WINDOW_MAX_CAPACITY 262144     // trades per symbol the ring grows to, power of two
+#define ANALYTICS_DEPTH_LEVELS 5                 // levels summed for book imbalance
+
+// Trade window of one symbol, columns kept as separate arrays in a ring that
+// doubles when full, up to ANALYTICS_WINDOW_MAX_CAPACITY rows
+typedef struct {
+    int64_t *ts;
+    double *notional;      // price * qty
+    double *qty;
+    double *signed_qty;    // +qty buyer initiated, -qty seller
+    double *ret2;          // squared log return to previous trade
+    uint32_t capacity;     // rows, power of two
+
+    uint32_t head;         // oldest row of the time window
+    uint32_t count_head;   // oldest row of the count window
+    uint32_t tail;         // next row to write
+
+    // Running sums, time window
+    double sum_notional;
+    double sum_qty;
+    double sum_signed_qty;
+    double sum_ret2;
+
+    // Running sums, count window
+    double count_notional;
+    double count_qty;
+
+    double last_price;
+    uint32_t appends_since_recompute;
+    uint64_t overflows;
+} analytics_window_t;
+
+typedef struct analytics {
+    int64_t window_ms;
+    uint32_t window_trades;
+    void (*on_update)(void *user, const analytics_snapshot_t *snapshot);
+    void *user;
+
+    // Symbol table, slot index is the column index below
+    char symbols[ANALYTICS_MAX_SYMBOLS][ANALYTICS_SYMBOL_SIZE];
+    bool in_use[ANALYTICS_MAX_SYMBOLS];
+    int symbol_count;
+    bool full_warned;
+
+    // Per symbol state, one column per field
+    analytics_window_t *windows[ANALYTICS_MAX_SYMBOLS];
+    int64_t last_ts[ANALYTICS_MAX_SYMBOLS];
+    double bid_px[ANALYTICS_MAX_SYMBOLS];
+    double bid_qty[ANALYTICS_MAX_SYMBOLS];
+    double ask_px[ANALYTICS_MAX_SYMBOLS];
+    double ask_qty[ANALYTICS_MAX_SYMBOLS];
+    double depth_bid_qty[ANALYTICS_MAX_SYMBOLS];
+    double depth_ask_qty[ANALYTICS_MAX_SYMBOLS];
+} analytics_t;
+
+// Create engine with time window (ms) and count window (trades), on_update may be NULL
+// and receives user unchanged
+analytics_t* analytics_create(int64_t window_ms, uint32_t window_trades,
+                              void (*on_update)(void *user, const analytics_snapshot_t *snapshot),
+                              void *user);
+
+// Feed aggTrade and bookTicker events, others are ignored
+void analytics_update(analytics_t *engine, const market_data_t *data);
+
+// Take book imbalance from a consistent order book after it changed, NULL book is ignored
+void analytics_update_book(analytics_t *engine, const char *symbol, const order_book_t *book,
+                           int64_t timestamp);
+
+// Drop trades older than window_ms before now_ms (exchange clock) from every time window,
+// so quiet symbols stop reporting stale values. Call periodically.
+void analytics_expire(analytics_t *engine, int64_t now_ms);
+
+// Fill snapshot for symbol, returns -1 if the symbol was never seen
+int analytics_snapshot(const analytics_t *engine, const char *symbol, analytics_snapshot_t *out);
+
+// Print one line per symbol
+void analytics_print(const analytics_t *engine);
+
+// Destroy engine
+void analytics_destroy(analytics_t *engine);
+
+#endif // ANALYTICS_H
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include "cryptostream_types.h"
+
+#define CONFIG_MAX_STREAMS 200
+
+// Output sink for parsed market data
+typedef enum {
+    SINK_STDOUT = 0,
+    SINK_STORE,
+    SINK_NONE
+} sink_type_t;
+
+typedef struct {
+    // Proxy settings
+    bool use_proxy;
+    char *proxy_address;
+    int proxy_port;
+    char *proxy_username;
+    char *proxy_password;
+
+    // Stream set to keep subscribed
+    char *streams[CONFIG_MAX_STREAMS];
+    int stream_count;
+
+    // Runtime settings
+    sink_type_t sink;
+    char *store_dir;
+    int send_queue_size;
+    bool parser_check;   // cross-check every parse against the json-c reference parser
+
+    // Derived metrics
+    bool analytics;
+    int analytics_window_ms;
+    int analytics_window_trades;
+
+    // Receive path tuning
+    socket_tuning_t socket;
+    int cpu_affinity;
+
+    // Order books from REST snapshots plus @depth diffs
+    bool depth_books;
+    char *rest_host;
+    int rest_port;
+    bool rest_tls;
+    int depth_snapshot_limit;
+    int rest_max_in_flight;
+    int rest_weight_limit;   // request weight per minute
+
+    // Cross-stream ordering by exchange event time
+    bool event_merge;
+    int merge_window_ms;         // longest an event waits for older ones
+    int merge_max_lateness_ms;   // events further behind the released ones are dropped
+    int merge_capacity;          // events held at most
+
+    // Metrics
+    int metrics_port;           // local Prometheus endpoint, 0 disables
+    int metrics_log_interval;   // seconds between metrics log lines, 0 disables
+} app_config_t;
+
+// Fill config with defaults
+void config_init(app_config_t *config);
+
+// Load key=value settings from file on top of the current values
+int config_load_file(const char *filename, app_config_t *config);
+
+// Add stream to the configured stream set (duplicates are ignored)
+int config_add_stream(app_config_t *config, const char *stream);
+
+// Release memory owned by config
+void config_free(app_config_t *config);
+
+// True if next differs from current in a setting that only takes effect on restart.
+// Streams, sink, parser check and the metrics log interval apply on reload, as does
+// store_dir until the store has been opened, which the caller has to check.
+bool config_needs_restart(const app_config_t *current, const app_config_t *next);
+
+// Parse sink name ("stdout", "store", "none"), returns -1 if unknown
+int config_parse_sink(const char *name, sink_type_t *sink);
+
+// Watch config file for changes, returns pollable fd or -1
+int config_watch(const char *filename);
+
+// Drain pending watch events, returns true if the config file changed
+bool config_watch_changed(int watch_fd, const char *filename);
+
+#endif // CONFIG_H
\ No newline at end of file
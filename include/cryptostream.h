@@ -0,0 +1,218 @@
+#ifndef CRYPTOSTREAM_H
+#define CRYPTOSTREAM_H
+
+// Embedding API of libcryptostream. The stream and merger handles are opaque;
+// the structs reachable from here (cryptostream_types.h and the callback table)
+// only ever grow at the end, so zero them before filling. Only the functions
+// declared here are exported from the shared library.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "cryptostream_types.h"
+
+#define CRYPTOSTREAM_VERSION_MAJOR 1
+#define CRYPTOSTREAM_VERSION_MINOR 3
+#define CRYPTOSTREAM_VERSION_PATCH 0
+
+#if defined(__GNUC__)
+#define CRYPTOSTREAM_API __attribute__((visibility("default")))
+#else
+#define CRYPTOSTREAM_API
+#endif
+
+typedef struct cryptostream cryptostream_t;
+typedef struct event_merger event_merger_t;
+typedef struct analytics analytics_t;
+typedef struct tick_store tick_store_t;
+
+// All callbacks run on the thread servicing the stream and get the user pointer
+// given to cryptostream_set_callbacks. Any of them may be NULL.
+typedef struct {
+    // Every complete message as received, including subscription responses
+    void (*on_message)(void *user, const char *data, size_t len);
+    // Parsed event and the message it came from, valid for the duration of the call
+    void (*on_market_data)(void *user, const market_data_t *data, const char *raw, size_t len);
+    // Every established connection, the wanted streams are subscribed right after
+    void (*on_connect)(void *user);
+    // Connection lost; a reconnect follows unless the stream is stopped or it is disabled
+    void (*on_disconnect)(void *user);
+    void (*on_error)(void *user, const char *error);
+    // Once per service loop iteration, at least every 50 ms in managed mode
+    void (*on_tick)(void *user);
+    // Status lines (connection, subscriptions, order book bootstrap), nothing is printed without it
+    void (*on_log)(void *user, const char *message);
+    // Gap, duplicate or reorder in the exchange ids of a stream, checked in arrival order.
+    // A depth gap has already dropped the book of the symbol and queued a new snapshot.
+    void (*on_sequence)(void *user, const seq_event_t *event);
+} cryptostream_callbacks_t;
+
+// Library version as "major.minor.patch"
+CRYPTOSTREAM_API const char* cryptostream_version(void);
+
+// Create a stream handle for a WebSocket endpoint, nothing connects until cryptostream_connect
+CRYPTOSTREAM_API cryptostream_t* cryptostream_create(const char *host, int port, const char *path);
+
+// Settings below apply to the next cryptostream_connect
+
+// Install callbacks (copied) and the user pointer handed back to them
+CRYPTOSTREAM_API void cryptostream_set_callbacks(cryptostream_t *stream,
+                                                 const cryptostream_callbacks_t *callbacks,
+                                                 void *user);
+
+// Connect through an HTTP proxy, username and password may be NULL
+CRYPTOSTREAM_API void cryptostream_set_proxy(cryptostream_t *stream, const char *address, int port,
+                                             const char *username, const char *password);
+
+// Socket options applied to the connection
+CRYPTOSTREAM_API void cryptostream_set_socket_tuning(cryptostream_t *stream,
+                                                     const socket_tuning_t *tuning);
+
+// Pin the thread running cryptostream_run or the managed thread to a CPU (-1 to disable)
+CRYPTOSTREAM_API void cryptostream_set_cpu_affinity(cryptostream_t *stream, int cpu);
+
+// Outbound queue capacity in messages
+CRYPTOSTREAM_API void cryptostream_set_send_queue_size(cryptostream_t *stream, int size);
+
+// Serve Prometheus metrics on 127.0.0.1:port (0 disables)
+CRYPTOSTREAM_API void cryptostream_set_metrics_port(cryptostream_t *stream, int port);
+
+// Reconnect after the connection is lost or fails, waiting initial_ms before the first
+// attempt and doubling up to max_ms (default 1 s to 30 s). initial_ms 0 disables.
+CRYPTOSTREAM_API void cryptostream_set_reconnect(cryptostream_t *stream, int initial_ms,
+                                                 int max_ms);
+
+// Keep order books for the diff depth streams, bootstrapped from REST snapshots
+CRYPTOSTREAM_API int cryptostream_set_depth_books(cryptostream_t *stream, const char *rest_host,
+                                                  int rest_port, bool rest_tls, int snapshot_limit,
+                                                  int max_in_flight, int weight_per_minute);
+
+// Reorder window releasing events in exchange time order to on_event. Events wait up to
+// window_ms of event time or local time; those more than max_lateness_ms behind the last
+// released one are dropped, closer ones are released with late set. Events stamped more than
+// 10 s ahead of the local receive time are dropped as well. capacity 0 picks a default.
+// on_event runs on the thread that pushed or drained and must not feed the same merger.
+CRYPTOSTREAM_API event_merger_t* cryptostream_merger_create(
+    int window_ms, int max_lateness_ms, size_t capacity,
+    void (*on_event)(void *user, const market_data_t *data, bool late), void *user);
+
+// Release every held event in order, e.g. before shutdown
+CRYPTOSTREAM_API void cryptostream_merger_flush(event_merger_t *merger);
+
+// Print counters: pushed, released, late (released out of order), late_dropped,
+// future_dropped, forced, hold time
+CRYPTOSTREAM_API void cryptostream_merger_print(event_merger_t *merger);
+
+// Free a merger no stream is attached to anymore, dropping held events
+CRYPTOSTREAM_API void cryptostream_merger_destroy(event_merger_t *merger);
+
+// After on_market_data, hand parsed events to merger (may be shared by several streams),
+// which releases them in exchange time order. Held events are flushed before on_disconnect.
+// NULL detaches.
+CRYPTOSTREAM_API void cryptostream_set_merger(cryptostream_t *stream, event_merger_t *merger);
+
+// Replace the wanted stream set, safe from any thread. Only the difference is sent,
+// on the service thread; after a reconnect the whole set is subscribed again.
+CRYPTOSTREAM_API int cryptostream_set_streams(cryptostream_t *stream, const char **streams,
+                                              int count);
+
+// Parse every event a second time with the json-c reference parser and compare,
+// safe from any thread. The first mismatches go to on_log.
+CRYPTOSTREAM_API void cryptostream_set_parser_check(cryptostream_t *stream, bool enabled);
+
+// Queue a raw text frame, safe from any thread. -1 when not connected or the queue is full.
+CRYPTOSTREAM_API int cryptostream_send(cryptostream_t *stream, const char *message);
+
+// Create the connection. Callbacks only run from cryptostream_poll, cryptostream_run
+// or the managed thread.
+CRYPTOSTREAM_API int cryptostream_connect(cryptostream_t *stream);
+
+// Caller thread mode: service once, waiting up to timeout_ms. -1 once stopped.
+CRYPTOSTREAM_API int cryptostream_poll(cryptostream_t *stream, int timeout_ms);
+
+// Caller thread mode: service on the calling thread until cryptostream_stop
+CRYPTOSTREAM_API void cryptostream_run(cryptostream_t *stream);
+
+// Managed mode: service on a library owned thread until cryptostream_stop
+CRYPTOSTREAM_API int cryptostream_start(cryptostream_t *stream);
+
+// Stop servicing, safe from any thread and from signal handlers
+CRYPTOSTREAM_API void cryptostream_stop(cryptostream_t *stream);
+
+// Wait for the managed thread to exit after cryptostream_stop
+CRYPTOSTREAM_API void cryptostream_join(cryptostream_t *stream);
+
+// Whether the WebSocket is currently connected
+CRYPTOSTREAM_API bool cryptostream_connected(const cryptostream_t *stream);
+
+// Order book for symbol (upper case) while consistent, NULL otherwise.
+// Only valid from callbacks or after the stream has stopped.
+CRYPTOSTREAM_API const order_book_t* cryptostream_book(const cryptostream_t *stream,
+                                                       const char *symbol);
+
+// Print order book state
+CRYPTOSTREAM_API void cryptostream_print_books(const cryptostream_t *stream);
+
+// Sequence counters of symbol (upper case) and stream type, NULL if never seen.
+// Only valid from callbacks or after the stream has stopped.
+CRYPTOSTREAM_API const seq_stream_t* cryptostream_sequence(const cryptostream_t *stream,
+                                                           const char *symbol,
+                                                           seq_stream_type_t type);
+
+// Print sequence counters of every stream seen
+CRYPTOSTREAM_API void cryptostream_print_sequence(const cryptostream_t *stream);
+
+// Name of a sequenced stream type, e.g. "aggTrade"
+CRYPTOSTREAM_API const char* cryptostream_sequence_type_name(seq_stream_type_t type);
+
+// Print how many events the parser check compared and how many differed, nothing if none
+CRYPTOSTREAM_API void cryptostream_print_parser_check(const cryptostream_t *stream);
+
+// One line per parsed event
+CRYPTOSTREAM_API void cryptostream_print_market_data(const market_data_t *data);
+
+// Rolling per symbol analytics (VWAP, microprice, imbalances, realized volatility) over a
+// window_ms time window and a window_trades count window. Feed it from callbacks; on_update
+// may be NULL and gets user unchanged.
+CRYPTOSTREAM_API analytics_t* cryptostream_analytics_create(
+    int64_t window_ms, uint32_t window_trades,
+    void (*on_update)(void *user, const analytics_snapshot_t *snapshot), void *user);
+
+// Feed aggTrade and bookTicker events, others are ignored
+CRYPTOSTREAM_API void cryptostream_analytics_update(analytics_t *engine, const market_data_t *data);
+
+// Book imbalance from a consistent order book (cryptostream_book), NULL book is ignored
+CRYPTOSTREAM_API void cryptostream_analytics_update_book(analytics_t *engine, const char *symbol,
+                                                         const order_book_t *book,
+                                                         int64_t timestamp);
+
+// Drop trades older than the time window before now_ms, an exchange time in ms
+CRYPTOSTREAM_API void cryptostream_analytics_expire(analytics_t *engine, int64_t now_ms);
+
+// Print one line per symbol
+CRYPTOSTREAM_API void cryptostream_analytics_print(const analytics_t *engine);
+
+CRYPTOSTREAM_API void cryptostream_analytics_destroy(analytics_t *engine);
+
+// Columnar on-disk store of aggTrade and bookTicker ticks under root_dir, created if missing
+CRYPTOSTREAM_API tick_store_t* cryptostream_store_open(const char *root_dir);
+
+// Append an aggTrade or bookTicker event, others are ignored
+CRYPTOSTREAM_API int cryptostream_store_append(tick_store_t *store, const market_data_t *data);
+
+// Start writeback of what was appended so far
+CRYPTOSTREAM_API int cryptostream_store_sync(tick_store_t *store);
+
+// Flush to disk and free the store
+CRYPTOSTREAM_API void cryptostream_store_close(tick_store_t *store);
+
+// One line with the main library counters and rates since the previous call
+CRYPTOSTREAM_API void cryptostream_metrics_log(FILE *out);
+
+// Release metric storage of the calling thread and of exited threads, after the last stream is destroyed
+CRYPTOSTREAM_API void cryptostream_metrics_shutdown(void);
+
+// Stop, join the managed thread, close the connection and free the handle
+CRYPTOSTREAM_API void cryptostream_destroy(cryptostream_t *stream);
+
+#endif // CRYPTOSTREAM_H
\ No newline at end of file
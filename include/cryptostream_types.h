@@ -0,0 +1,155 @@
+#ifndef CRYPTOSTREAM_TYPES_H
+#define CRYPTOSTREAM_TYPES_H
+
+// Structs shared between libcryptostream and embedders. Installed with
+// cryptostream.h; new fields only ever go at the end.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Event types known to the parser: enum id, "e" value, stream name prefix
+#define MARKET_EVENT_TYPES(X) \
+    X(AGG_TRADE,   "aggTrade",        "aggTrade")   \
+    X(MARK_PRICE,  "markPriceUpdate", "markPrice")  \
+    X(KLINE,       "kline",           "kline_")     \
+    X(TICKER,      "24hrTicker",      "ticker")     \
+    X(BOOK_TICKER, "bookTicker",      "bookTicker") \
+    X(DEPTH,       "depthUpdate",     "depth")
+
+typedef enum {
+    MARKET_EVENT_NONE = 0,   // subscription responses and unknown events
+#define X(id, name, stream) MARKET_EVENT_##id,
+    MARKET_EVENT_TYPES(X)
+#undef X
+    MARKET_EVENT_COUNT
+} market_event_t;
+
+typedef struct {
+    market_event_t event;
+    const char *event_type;   // static name of event, NULL for responses and unknown events
+    char *symbol;
+    double price;
+    double quantity;
+    long timestamp;     // "T", trade or transaction time
+    bool is_buyer_maker;
+    
+    // For depth updates
+    double *bid_prices;
+    double *bid_quantities;
+    double *ask_prices;
+    double *ask_quantities;
+    int bid_count;
+    int ask_count;
+    
+    // For kline data
+    long open_time;
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;
+    long close_time;
+    
+    // Exchange sequence ids
+    long agg_trade_id;          // aggTrade "a"
+    long first_trade_id;        // aggTrade "f"
+    long last_trade_id;         // aggTrade "l"
+    long first_update_id;       // depthUpdate "U"
+    long final_update_id;       // depthUpdate / bookTicker "u"
+    long prev_final_update_id;  // depthUpdate "pu" (futures only)
+    
+    // Local receive time (ns since epoch), kernel stamped when available
+    int64_t receive_time_ns;
+
+    long event_time;            // "E", exchange time the event was pushed
+} market_data_t;
+
+// One side of a book, price and quantity kept as separate sorted arrays.
+// Bids are sorted by descending price, asks by ascending price.
+typedef struct {
+    double *prices;
+    double *quantities;
+    int count;
+    int capacity;
+} book_side_t;
+
+typedef struct {
+    book_side_t bids;
+    book_side_t asks;
+    long last_update_id;   // "u" of the last applied diff or snapshot lastUpdateId
+} order_book_t;
+
+// Socket options applied to the WebSocket connection
+typedef struct {
+    int rcvbuf;            // SO_RCVBUF in bytes, 0 keeps the kernel default
+    bool tcp_nodelay;      // TCP_NODELAY
+    int busy_poll_us;      // SO_BUSY_POLL in microseconds, 0 disables
+    bool tcp_quickack;     // TCP_QUICKACK, re-armed after every receive
+    bool rx_timestamping;  // SO_TIMESTAMPING for kernel receive timestamps
+} socket_tuning_t;
+
+#define SEQ_SYMBOL_SIZE 24
+
+// Result of checking one message against the ids its stream carried before
+typedef enum {
+    SEQ_OK = 0,
+    SEQ_GAP,          // ids skipped: "a" for aggTrade, "U"/"pu" for depthUpdate
+    SEQ_DUPLICATE,
+    SEQ_REORDER,
+    SEQ_UNTRACKED,    // no sequence ids, or the tracker is full
+    SEQ_TRADE_GAP     // "a" continued but "f" did not follow the previous "l"
+} seq_status_t;
+
+// Event types carrying sequence ids
+typedef enum {
+    SEQ_STREAM_AGG_TRADE = 0,
+    SEQ_STREAM_BOOK_TICKER,
+    SEQ_STREAM_DEPTH,
+    SEQ_STREAM_TYPES
+} seq_stream_type_t;
+
+// Per symbol and stream type counters
+typedef struct {
+    char symbol[SEQ_SYMBOL_SIZE];
+    seq_stream_type_t type;
+    bool in_use;
+    bool has_last;
+    long last_id;
+    uint64_t messages;
+    uint64_t gaps;
+    uint64_t missing;
+    uint64_t duplicates;
+    uint64_t reorders;
+    long last_trade_id;        // "l" of the last aggTrade, 0 before the first
+    uint64_t trade_gaps;
+    uint64_t missing_trades;
+} seq_stream_t;
+
+// Reported for every gap, duplicate or reorder
+typedef struct {
+    seq_status_t status;
+    seq_stream_type_t type;
+    const char *symbol;
+    long expected;   // id the stream should have continued from
+    long received;   // id carried by the message
+    long missing;    // ids skipped, 0 when unknown or not a gap
+    const seq_stream_t *stream;
+} seq_event_t;
+
+// Derived metrics of one symbol, see cryptostream_analytics_create
+typedef struct {
+    const char *symbol;
+    int64_t timestamp;        // exchange time of the last event (ms)
+    double vwap;              // over the time window
+    double vwap_count;        // over the last window_trades trades
+    double microprice;        // size weighted mid from best bid/ask
+    double top_imbalance;     // (bid_qty - ask_qty) / (bid_qty + ask_qty) at the touch
+    double book_imbalance;    // same over the first 5 levels of the order book
+    double trade_imbalance;   // (buy_qty - sell_qty) / total_qty over the time window
+    double realized_vol;      // sqrt of summed squared log returns over the time window
+    uint32_t window_trades;   // trades currently in the time window
+    uint64_t window_overflows;   // trades dropped from a full ring while still inside the time window
+} analytics_snapshot_t;
+
+#endif // CRYPTOSTREAM_TYPES_H
\ No newline at end of file
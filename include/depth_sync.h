@@ -0,0 +1,105 @@
+#ifndef DEPTH_SYNC_H
+#define DEPTH_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "json_parser.h"
+#include "order_book.h"
+#include "snapshot_fetcher.h"
+
+#define DEPTH_SYNC_MAX_SYMBOLS 512   // power of two
+#define DEPTH_SYNC_SYMBOL_SIZE 24
+#define DEPTH_SYNC_RING 256          // diffs buffered per symbol while a snapshot is in flight
+#define DEPTH_SYNC_RETRY_NS (5LL * 1000000000LL)
+
+typedef enum {
+    BOOK_WAIT_SNAPSHOT = 0,   // buffering diffs, snapshot request not started yet
+    BOOK_FETCHING,            // buffering diffs, snapshot request in flight
+    BOOK_SNAPSHOT,            // snapshot merged, not yet confirmed by a diff straddling it
+    BOOK_LIVE                 // diffs applied as they arrive
+} book_state_t;
+
+// Buffered diff, level arrays are owned and reused by the ring slot
+typedef struct {
+    long first_update_id;   // U
+    long final_update_id;   // u
+    long prev_final_update_id;   // pu, 0 when the stream does not send it
+    int bid_count;
+    int ask_count;
+    int bid_capacity;
+    int ask_capacity;
+    double *bid_prices;
+    double *bid_quantities;
+    double *ask_prices;
+    double *ask_quantities;
+} depth_diff_t;
+
+typedef struct {
+    char symbol[DEPTH_SYNC_SYMBOL_SIZE];
+    book_state_t state;
+    order_book_t book;
+    bool first_applied;       // a diff has been applied on top of the snapshot
+    int64_t retry_at_ns;      // earliest time for the next snapshot request
+
+    depth_diff_t *ring;       // allocated on first buffering
+    uint32_t head;
+    uint32_t tail;
+
+    uint64_t diffs_applied;
+    uint64_t resyncs;
+} depth_symbol_t;
+
+typedef struct {
+    snapshot_fetcher_t *fetcher;
+
+    depth_symbol_t *symbols[DEPTH_SYNC_MAX_SYMBOLS];   // hashed by symbol, NULL when free
+    int symbol_count;
+    int live_count;
+    int pump_cursor;
+    bool full_warned;
+
+    int64_t sync_started_ns;   // first symbol became unsynced, 0 while all books are live
+
+    // Status lines, dropped when NULL
+    void (*on_log)(void *user, const char *message);
+    void *log_user;
+} depth_sync_t;
+
+// Create book synchronizer fetching snapshots through an existing lws context
+depth_sync_t* depth_sync_create(struct lws_context *context, const char *rest_host, int rest_port,
+                                bool rest_tls, int snapshot_limit, int max_in_flight,
+                                int weight_per_minute);
+
+// Keep a book for every diff depth stream (symbol@depth or symbol@depth@<speed>) in the list
+// and drop the books of symbols no longer listed
+void depth_sync_track_streams(depth_sync_t *sync, const char **streams, int count);
+
+// Keep a book for symbol (upper case, as carried in events)
+int depth_sync_track(depth_sync_t *sync, const char *symbol);
+
+// Free the book of symbol and abandon its snapshot request, -1 when not tracked
+int depth_sync_untrack(depth_sync_t *sync, const char *symbol);
+
+// Feed a depthUpdate event, other events are ignored
+void depth_sync_update(depth_sync_t *sync, const market_data_t *data);
+
+// Drop the book of symbol after a sequence gap seen upstream and fetch a new snapshot,
+// -1 when not tracked
+int depth_sync_resync(depth_sync_t *sync, const char *symbol);
+
+// Start snapshot requests allowed by the limits, call from the service loop
+void depth_sync_pump(depth_sync_t *sync);
+
+// Book of symbol when live (a diff has continued the snapshot), NULL otherwise
+const order_book_t* depth_sync_book(const depth_sync_t *sync, const char *symbol);
+
+// Drop every book, e.g. after reconnecting; diffs are buffered again until new snapshots arrive
+void depth_sync_reset_all(depth_sync_t *sync);
+
+// Print one line per book
+void depth_sync_print(const depth_sync_t *sync);
+
+// Destroy; call after the lws context is destroyed
+void depth_sync_destroy(depth_sync_t *sync);
+
+#endif // DEPTH_SYNC_H
\ No newline at end of file
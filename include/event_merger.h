@@ -0,0 +1,41 @@
+#ifndef EVENT_MERGER_H
+#define EVENT_MERGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "json_parser.h"
+
+#define EVENT_MERGER_DEFAULT_CAPACITY 4096
+// Events stamped further than this ahead of the local receive time are dropped
+#define EVENT_MERGER_MAX_AHEAD_MS 10000
+
+// Called for every released event in exchange time order. late marks an event
+// released behind the watermark within the lateness bound. Runs under the
+// merger lock on the releasing thread, so it must not push to the same merger.
+typedef void (*event_merger_fn)(void *user, const market_data_t *data, bool late);
+
+// Reorder window, may be fed by several streams
+typedef struct event_merger event_merger_t;
+
+// Create merger. Events are held up to window_ms of event time or of local time,
+// whichever runs out first. capacity 0 uses EVENT_MERGER_DEFAULT_CAPACITY.
+event_merger_t* event_merger_create(int window_ms, int max_lateness_ms, size_t capacity,
+                                    event_merger_fn on_event, void *user);
+
+// Take ownership of a parsed event and release whatever became ready. Safe from any thread.
+void event_merger_push(event_merger_t *merger, market_data_t *data, int64_t now_ns);
+
+// Release events held for the full window of local time, call periodically
+void event_merger_drain(event_merger_t *merger, int64_t now_ns);
+
+// Release all held events in order
+void event_merger_flush(event_merger_t *merger);
+
+// Print merge statistics
+void event_merger_print(event_merger_t *merger);
+
+// Free merger and any events still held
+void event_merger_destroy(event_merger_t *merger);
+
+#endif // EVENT_MERGER_H
\ No newline at end of file
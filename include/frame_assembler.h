@@ -0,0 +1,40 @@
+#ifndef FRAME_ASSEMBLER_H
+#define FRAME_ASSEMBLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Outcome of pushing one fragment
+typedef enum {
+    FRAME_PARTIAL = 0,   // more fragments needed
+    FRAME_COMPLETE,      // buffer holds a whole NUL terminated message
+    FRAME_DROPPED        // message exceeded max_size or memory ran out, skipped to its end
+} frame_status_t;
+
+// Reassembles WebSocket messages delivered in several receive callbacks.
+// The buffer is kept between messages so steady state receives do not allocate.
+typedef struct {
+    char *buffer;
+    size_t len;
+    size_t capacity;
+    size_t max_size;
+    bool in_message;   // a first fragment was seen and the final one not yet
+    bool dropping;     // current message is being discarded
+    unsigned long dropped;
+} frame_assembler_t;
+
+// Initialize with a message size limit in bytes
+void frame_assembler_init(frame_assembler_t *assembler, size_t max_size);
+
+// Append a fragment. first/final mark message boundaries (lws_is_first_fragment /
+// lws_is_final_fragment). On FRAME_COMPLETE the message is buffer[0..len).
+frame_status_t frame_assembler_push(frame_assembler_t *assembler, const void *data, size_t len,
+                                    bool first, bool final);
+
+// Forget any partial message, e.g. when the connection closes
+void frame_assembler_reset(frame_assembler_t *assembler);
+
+// Release the buffer
+void frame_assembler_free(frame_assembler_t *assembler);
+
+#endif // FRAME_ASSEMBLER_H
\ No newline at end of file
@@ -1,39 +1,47 @@
 #ifndef JSON_PARSER_H
 #define JSON_PARSER_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "cryptostream_types.h"
 
-typedef struct {
-    char *event_type;
-    char *symbol;
-    double price;
-    double quantity;
-    long timestamp;
-    
-    // For depth updates
-    double *bid_prices;
-    double *bid_quantities;
-    double *ask_prices;
-    double *ask_quantities;
-    int bid_count;
-    int ask_count;
-    
-    // For kline data
-    long open_time;
-    double open;
-    double high;
-    double low;
-    double close;
-    double volume;
-    long close_time;
-} market_data_t;
-
-// Parse market data from JSON
+typedef market_data_t* (*market_parser_fn)(const char *json_str, size_t len);
+
+// Parse market data from JSON, dispatching on the "e" field
 market_data_t* parse_market_data(const char *json_str, size_t len);
 
+// Reference parser (json_parser_reference.c): one json_object_object_get_ex per field,
+// written out per event without the field tables, slow but independent of the
+// single pass fillers. Errors and subscription responses yield no event.
+market_data_t* parse_market_data_reference(const char *json_str, size_t len);
+
+// Parse a REST depth snapshot ({"lastUpdateId", "bids", "asks"}). final_update_id holds
+// lastUpdateId and the event is MARKET_EVENT_NONE. NULL if malformed.
+market_data_t* parse_depth_snapshot(const char *json_str, size_t len);
+
+// Name of the first field that differs between two parse results, NULL if equal.
+// Response bookkeeping (printed messages) is not compared.
+const char* market_data_compare(const market_data_t *a, const market_data_t *b);
+
+// Event name ("aggTrade", ...), "none" for MARKET_EVENT_NONE
+const char* market_event_name(market_event_t event);
+
+// Event type carried by a stream name such as "btcusdt@aggTrade"
+market_event_t market_event_from_stream(const char *stream);
+
+// Parser specialized for one event type, generic parser for MARKET_EVENT_NONE
+market_parser_fn market_parser_for(market_event_t event);
+
+// Specialized parser when all streams carry the same event type, generic otherwise
+market_parser_fn market_parser_for_streams(const char **streams, int count);
+
 // Free market data
 void free_market_data(market_data_t *data);
 
+// Free the calling thread's reusable parser state, before a parsing thread exits
+void free_parser_thread_state(void);
+
 // Print market data
 void print_market_data(const market_data_t *data);
 
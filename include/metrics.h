@@ -0,0 +1,124 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "json_parser.h"
+
+#define METRICS_MAX_STREAMS 512   // (symbol, event) pairs tracked, power of two
+#define METRICS_SYMBOL_SIZE 24
+
+// Counters: id, Prometheus name, help text
+#define METRIC_COUNTERS(X) \
+    X(MESSAGES_RECEIVED,  "cryptostream_messages_received_total",  "WebSocket messages received")        \
+    X(BYTES_RECEIVED,     "cryptostream_bytes_received_total",     "WebSocket payload bytes received")   \
+    X(MESSAGES_SENT,      "cryptostream_messages_sent_total",      "WebSocket messages sent")            \
+    X(BYTES_SENT,         "cryptostream_bytes_sent_total",         "WebSocket payload bytes sent")       \
+    X(SEND_DROPS,         "cryptostream_send_drops_total",         "Messages rejected by the send queue") \
+    X(FRAMES_DROPPED,     "cryptostream_frames_dropped_total",     "Oversized messages dropped")         \
+    X(PARSE_FAILURES,     "cryptostream_parse_failures_total",     "Messages the parser rejected")       \
+    X(SEQUENCE_ANOMALIES, "cryptostream_sequence_anomalies_total", "Sequence gaps, duplicates and reorders") \
+    X(CONNECTS,           "cryptostream_connects_total",           "WebSocket connections established")  \
+    X(DISCONNECTS,        "cryptostream_disconnects_total",        "WebSocket connections closed")       \
+    X(CONNECTION_ERRORS,  "cryptostream_connection_errors_total",  "WebSocket connection errors")        \
+    X(RECONNECTS,         "cryptostream_reconnects_total",         "WebSocket reconnect attempts")       \
+    X(ALLOCATIONS,        "cryptostream_allocations_total",        "Heap allocations on the receive path") \
+    X(SNAPSHOTS_FETCHED,  "cryptostream_snapshots_fetched_total",  "REST depth snapshots received")      \
+    X(SNAPSHOT_FAILURES,  "cryptostream_snapshot_failures_total",  "REST depth snapshot requests failed") \
+    X(BOOK_RESYNCS,       "cryptostream_book_resyncs_total",       "Live order books that lost continuity") \
+    X(DIFFS_DROPPED,      "cryptostream_diffs_dropped_total",      "Depth diffs dropped from a full buffer") \
+    X(EVENTS_MERGED,      "cryptostream_events_merged_total",      "Events released in event time order") \
+    X(MERGE_HOLD_NANOSECONDS, "cryptostream_merge_hold_nanoseconds_total", "Time events were held for reordering") \
+    X(LATE_EVENTS,        "cryptostream_late_events_total",        "Events released behind the watermark within the lateness bound") \
+    X(LATE_DROPS,         "cryptostream_late_drops_total",         "Events dropped for arriving beyond the lateness bound") \
+    X(FUTURE_DROPS,       "cryptostream_future_drops_total",       "Events dropped for an exchange time too far ahead of the local clock") \
+    X(MERGE_FORCED,       "cryptostream_merge_forced_total",       "Events released early from a full reorder window") \
+    X(ANALYTICS_WINDOW_OVERFLOWS, "cryptostream_analytics_window_overflows_total", "Trades dropped from a full analytics window before leaving it") \
+    X(LOOP_ITERATIONS,    "cryptostream_loop_iterations_total",    "Service loop iterations")            \
+    X(LOOP_NANOSECONDS,   "cryptostream_loop_nanoseconds_total",   "Time spent handling events in service loop iterations, idle waits excluded")
+
+// Gauges: id, Prometheus name, help text
+#define METRIC_GAUGES(X) \
+    X(CONNECTED,        "cryptostream_connected",          "1 while the WebSocket is connected") \
+    X(SUBSCRIPTIONS,    "cryptostream_subscriptions",      "Streams currently subscribed")       \
+    X(SEND_QUEUE_DEPTH, "cryptostream_send_queue_depth",   "Messages waiting in the send queue") \
+    X(LOOP_LAST_NS,     "cryptostream_loop_last_nanoseconds", "Event handling time of the last service loop iteration") \
+    X(BOOKS_LIVE,       "cryptostream_books_live",         "Order books consistent with the exchange") \
+    X(BOOK_SYNC_NS,     "cryptostream_book_sync_nanoseconds", "Time from books out of sync until all were consistent") \
+    X(MERGE_PENDING,    "cryptostream_merge_pending",      "Events held in the reorder window")
+
+typedef enum {
+#define X(id, name, help) METRIC_##id,
+    METRIC_COUNTERS(X)
+#undef X
+    METRIC_COUNTER_COUNT
+} metric_counter_t;
+
+typedef enum {
+#define X(id, name, help) METRIC_##id,
+    METRIC_GAUGES(X)
+#undef X
+    METRIC_GAUGE_COUNT
+} metric_gauge_t;
+
+// Counters owned by one thread. Only the owner writes, readers sum all shards,
+// so recording is a plain load and store without a locked instruction.
+typedef struct metrics_shard {
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    _Atomic uint64_t stream_messages[METRICS_MAX_STREAMS];
+    _Atomic uint64_t stream_bytes[METRICS_MAX_STREAMS];
+    bool exited;   // owner thread has exited, guarded by the registry lock
+    struct metrics_shard *next;
+} metrics_shard_t;
+
+extern _Thread_local metrics_shard_t *metrics_thread_shard;
+
+// Register the calling thread's shard, NULL if out of memory
+metrics_shard_t* metrics_attach_thread(void);
+
+static inline void metrics_add(metric_counter_t id, uint64_t n) {
+    metrics_shard_t *shard = metrics_thread_shard ? metrics_thread_shard : metrics_attach_thread();
+    if (shard) {
+        uint64_t value = atomic_load_explicit(&shard->counters[id], memory_order_relaxed);
+        atomic_store_explicit(&shard->counters[id], value + n, memory_order_relaxed);
+    }
+}
+
+static inline void metrics_inc(metric_counter_t id) {
+    metrics_add(id, 1);
+}
+
+// Monotonic clock for durations
+static inline int64_t metrics_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Set a gauge, last writer wins
+void metrics_gauge_set(metric_gauge_t id, int64_t value);
+
+// Count one message of len bytes for a (symbol, event) stream
+void metrics_record_stream(const char *symbol, market_event_t event, size_t len);
+
+// Counter summed over all threads
+uint64_t metrics_counter_value(metric_counter_t id);
+
+// Gauge value
+int64_t metrics_gauge_value(metric_gauge_t id);
+
+// Render all metrics in Prometheus text format, caller frees
+char* metrics_prometheus_text(size_t *len);
+
+// One compact line with the main counters, rates since the previous call
+void metrics_log_line(FILE *out);
+
+// Free the calling thread's shard and those of exited threads and zero the rest.
+// Shards of threads still running stay allocated, so they may keep recording.
+void metrics_shutdown(void);
+
+#endif // METRICS_H
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef METRICS_HTTP_H
+#define METRICS_HTTP_H
+
+#include <libwebsockets.h>
+
+// Serve GET /metrics in Prometheus text format from a new vhost on an existing
+// context, so scrapes are handled by the same service loop. Returns -1 on failure.
+int metrics_http_listen(struct lws_context *context, const char *iface, int port);
+
+#endif // METRICS_HTTP_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <stdbool.h>
+#include "cryptostream_types.h"
+
+// Set a level to an absolute quantity, quantity 0 removes it. Returns -1 on allocation failure.
+int order_book_set(order_book_t *book, bool bid, double price, double quantity);
+
+// Replace both sides with the given levels (snapshot)
+int order_book_load(order_book_t *book, const double *bid_prices, const double *bid_quantities,
+                    int bid_count, const double *ask_prices, const double *ask_quantities,
+                    int ask_count, long last_update_id);
+
+// Remove all levels, keep the allocated arrays
+void order_book_clear(order_book_t *book);
+
+// Best bid/ask, false when that side is empty
+bool order_book_best_bid(const order_book_t *book, double *price, double *quantity);
+bool order_book_best_ask(const order_book_t *book, double *price, double *quantity);
+
+// Free level arrays
+void order_book_free(order_book_t *book);
+
+#endif // ORDER_BOOK_H
\ No newline at end of file
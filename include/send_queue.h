@@ -0,0 +1,47 @@
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SEND_QUEUE_MESSAGE_SIZE 16384   // largest message a slot holds
+
+// Bounded multi-producer, single-consumer queue of outbound messages.
+// All slots are allocated up front, each with `headroom` bytes in front of the
+// payload for protocol framing (LWS_PRE), so a queued message is written in place.
+// Any thread may push; only the service thread peeks, pops and clears.
+typedef struct {
+    _Atomic size_t *sequences;   // per slot turn counter
+    size_t *lengths;
+    unsigned char *slots;
+    size_t capacity;             // power of two
+    size_t headroom;
+    size_t stride;               // bytes per slot: headroom + payload, rounded up
+
+    _Alignas(64) _Atomic size_t enqueue_pos;
+    _Alignas(64) size_t dequeue_pos;
+} send_queue_t;
+
+// Create queue with room for at least capacity messages
+send_queue_t* send_queue_create(size_t capacity, size_t headroom);
+
+// Copy a message in, from any thread. Returns -1 if full or too large, never blocks.
+int send_queue_push(send_queue_t *queue, const void *data, size_t len);
+
+// Oldest message without removing it, NULL if empty. headroom bytes before it are writable.
+unsigned char* send_queue_peek(send_queue_t *queue, size_t *len);
+
+// Release the message returned by send_queue_peek
+void send_queue_pop(send_queue_t *queue);
+
+// Messages currently queued, approximate while producers are active
+size_t send_queue_depth(send_queue_t *queue);
+
+// Drop all queued messages
+void send_queue_clear(send_queue_t *queue);
+
+// Destroy queue
+void send_queue_destroy(send_queue_t *queue);
+
+#endif // SEND_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "json_parser.h"
+
+#define SEQ_MAX_STREAMS 1024
+
+typedef struct {
+    seq_stream_t streams[SEQ_MAX_STREAMS];
+    int stream_count;
+    bool full_warned;
+    void (*on_event)(void *user, const seq_event_t *event);
+    void *user;
+} seq_tracker_t;
+
+// Create tracker, on_event may be NULL and receives user unchanged
+seq_tracker_t* seq_tracker_create(void (*on_event)(void *user, const seq_event_t *event),
+                                  void *user);
+
+// Check message ids against the last seen ids for its stream
+seq_status_t seq_tracker_check(seq_tracker_t *tracker, const market_data_t *data);
+
+// Find counters for a symbol and stream type, NULL if never seen
+const seq_stream_t* seq_tracker_find(const seq_tracker_t *tracker, const char *symbol,
+                                     seq_stream_type_t type);
+
+// Forget the last id of one stream, e.g. after a downstream resync
+void seq_tracker_reset(seq_tracker_t *tracker, const char *symbol, seq_stream_type_t type);
+
+// Forget the last id of every stream, e.g. after reconnecting
+void seq_tracker_reset_all(seq_tracker_t *tracker);
+
+// Print per stream counters
+void seq_tracker_print(const seq_tracker_t *tracker);
+
+// Name of stream type
+const char* seq_stream_type_name(seq_stream_type_t type);
+
+// Destroy tracker
+void seq_tracker_destroy(seq_tracker_t *tracker);
+
+#endif // SEQUENCE_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef SNAPSHOT_FETCHER_H
+#define SNAPSHOT_FETCHER_H
+
+#include <libwebsockets.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SNAPSHOT_MAX_BODY (8 * 1024 * 1024)
+
+// Called once per request. status is the HTTP status, or -1 when the request
+// failed before a response. body is NUL terminated and only valid during the call.
+typedef void (*snapshot_done_fn)(void *ctx, const char *symbol, int status,
+                                 const char *body, size_t len);
+
+struct snapshot_request;
+
+// REST client for /fapi/v1/depth on its own vhost of an existing lws context.
+// Requests run on the service loop; in-flight count and request weight are limited.
+typedef struct {
+    struct lws_context *context;
+    struct lws_vhost *vhost;
+    char *host;
+    int port;
+    bool tls;
+    int limit;                 // depth levels requested
+    int weight;                // exchange weight of one request at this limit
+
+    int max_in_flight;
+    int in_flight;
+    double weight_per_minute;
+    double tokens;             // weight budget available now
+    int64_t refilled_ns;
+    int64_t backoff_until_ns;  // set after 418/429 responses
+    struct snapshot_request *requests;   // open connections
+
+    snapshot_done_fn on_done;
+    void *ctx;
+} snapshot_fetcher_t;
+
+// Create fetcher, NULL if the vhost cannot be created
+snapshot_fetcher_t* snapshot_fetcher_create(struct lws_context *context, const char *host, int port,
+                                            bool tls, int limit, int max_in_flight,
+                                            int weight_per_minute, snapshot_done_fn on_done,
+                                            void *ctx);
+
+// True when a request can start now without exceeding the limits
+bool snapshot_fetcher_ready(snapshot_fetcher_t *fetcher, int64_t now_ns);
+
+// Start fetching a snapshot for symbol, returns -1 if it could not start
+int snapshot_fetcher_start(snapshot_fetcher_t *fetcher, const char *symbol, int64_t now_ns);
+
+// Abandon requests for symbol: on_done is not called for them and their connections close
+void snapshot_fetcher_cancel(snapshot_fetcher_t *fetcher, const char *symbol);
+
+// Destroy fetcher; call after the context is destroyed so no request is still running
+void snapshot_fetcher_destroy(snapshot_fetcher_t *fetcher);
+
+#endif // SNAPSHOT_FETCHER_H
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef SOCKET_TUNING_H
+#define SOCKET_TUNING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cryptostream_types.h"
+
+// Apply socket options to a connected or connecting socket
+int socket_tuning_apply(int fd, const socket_tuning_t *tuning);
+
+// Re-arm options the kernel clears after each receive (TCP_QUICKACK)
+void socket_tuning_rearm(int fd, const socket_tuning_t *tuning);
+
+// Route TLS reads through recvmsg so kernel receive timestamps land in *stamp_ns
+int socket_tuning_attach_rx_timestamps(void *ssl, int fd, int64_t *stamp_ns);
+
+// Pin the calling thread to a CPU, cpu < 0 leaves affinity unchanged
+int socket_tuning_set_thread_cpu(int cpu);
+
+// Wall clock time in nanoseconds
+int64_t socket_tuning_now_ns(void);
+
+#endif // SOCKET_TUNING_H
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef SYMBOL_HASH_H
+#define SYMBOL_HASH_H
+
+// FNV-1a over a symbol name mixed with a small integer (stream type, kind)
+static inline unsigned int symbol_hash(const char *symbol, unsigned int salt) {
+    unsigned int hash = 2166136261u;
+    for (const char *p = symbol; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    hash ^= salt;
+    hash *= 16777619u;
+    return hash;
+}
+
+#endif // SYMBOL_HASH_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef TICK_STORE_H
+#define TICK_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "json_parser.h"
+
+#define TICK_STORE_BLOCK_ROWS 1024
+#define TICK_STORE_MAX_SEGMENTS 512
+#define TICK_STORE_SYMBOL_SIZE 24
+
+// Normalized event kinds, each stored in its own segment
+typedef enum {
+    TICK_KIND_TRADE = 0,
+    TICK_KIND_QUOTE,
+    TICK_KINDS
+} tick_kind_t;
+
+typedef enum {
+    TICK_SIDE_BUY = 0,   // aggressive buyer
+    TICK_SIDE_SELL,      // aggressive seller
+    TICK_SIDE_BID,       // best bid quote
+    TICK_SIDE_ASK        // best ask quote
+} tick_side_t;
+
+typedef struct {
+    int64_t timestamp;   // exchange time in milliseconds
+    double price;
+    double quantity;
+    tick_side_t side;
+} tick_t;
+
+// Decoded rows handed to query callbacks, one array per column
+typedef struct {
+    int64_t timestamp[TICK_STORE_BLOCK_ROWS];
+    double price[TICK_STORE_BLOCK_ROWS];
+    double quantity[TICK_STORE_BLOCK_ROWS];
+    uint8_t side[TICK_STORE_BLOCK_ROWS];
+    size_t count;
+} tick_batch_t;
+
+typedef struct tick_segment tick_segment_t;
+
+typedef struct tick_store {
+    char *root_dir;
+    tick_segment_t *segments[TICK_STORE_MAX_SEGMENTS];
+    int segment_count;
+    bool full_warned;
+} tick_store_t;
+
+// Open store rooted at directory, created if missing
+tick_store_t* tick_store_open(const char *root_dir);
+
+// Append one normalized event to the symbol's segment for the event's day
+int tick_store_append(tick_store_t *store, const char *symbol, tick_kind_t kind, const tick_t *tick);
+
+// Normalize and append aggTrade and bookTicker events, others are ignored
+int tick_store_append_market_data(tick_store_t *store, const market_data_t *data);
+
+// Scan rows with t0 <= timestamp <= t1, returns number of rows delivered or -1
+int64_t tick_store_query(const char *root_dir, const char *symbol, tick_kind_t kind,
+                         int64_t t0, int64_t t1,
+                         void (*on_batch)(const tick_batch_t *batch, void *ctx), void *ctx);
+
+// Start writeback of mapped segments, also done for each segment when its day rolls over
+int tick_store_sync(tick_store_t *store);
+
+// Flush segments to disk, unmap them and free store
+void tick_store_close(tick_store_t *store);
+
+#endif // TICK_STORE_H
\ No newline at end of file
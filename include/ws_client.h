@@ -3,9 +3,17 @@
 
 #include <libwebsockets.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "socket_tuning.h"
+#include "frame_assembler.h"
+#include "send_queue.h"
 
 #define MAX_PAYLOAD_SIZE 65536
-#define MAX_SUBSCRIPTIONS 10
+#define MAX_SUBSCRIPTIONS 200
+#define MAX_MESSAGE_SIZE (4 * 1024 * 1024)   // reassembled messages above this are dropped
+#define DEFAULT_SEND_QUEUE_SIZE 64
+#define RECONNECT_INITIAL_MS 1000   // first retry after a lost or failed connection
+#define RECONNECT_MAX_MS 30000      // retries back off by doubling up to this
 
 typedef struct {
     struct lws_context *context;
@@ -13,8 +21,8 @@ typedef struct {
     char *server_address;
     int port;
     char *path;
-    bool connected;
-    bool running;
+    atomic_bool connected;
+    atomic_bool running;
     
     // Proxy settings
     bool use_proxy;
@@ -23,15 +31,49 @@ typedef struct {
     char *proxy_username;
     char *proxy_password;
     
+    // Socket and service thread tuning
+    socket_tuning_t socket_tuning;
+    int cpu_affinity;
+    
+    // Receive timestamp of the last delivered message (ns since epoch),
+    // taken from the kernel when SO_TIMESTAMPING is active
+    int64_t rx_timestamp_ns;
+    int64_t kernel_rx_ns;
+    
+    // Time spent in callbacks during the current service iteration
+    int64_t busy_ns;
+    
+    // Reassembly of messages split over several receive callbacks
+    frame_assembler_t rx_frame;
+    
+    // Outbound messages, written one per LWS_CALLBACK_CLIENT_WRITEABLE
+    send_queue_t *send_queue;
+    int send_queue_size;
+    
+    // Local Prometheus endpoint port, 0 disables
+    int metrics_port;
+    
+    // Reconnect on the same context after the connection is lost, 0 disables
+    int reconnect_initial_ms;
+    int reconnect_max_ms;
+    int reconnect_delay_ms;      // wait before the next attempt
+    int64_t reconnect_at_ns;     // metrics clock, 0 while none is scheduled
+    int reconnect_attempts;      // since the last established connection
+    
     // Subscription management
     char *subscriptions[MAX_SUBSCRIPTIONS];
     int subscription_count;
+    int next_request_id;
     
-    // Callback for received data
-    void (*on_message)(const char *data, size_t len);
-    void (*on_connect)(void);
-    void (*on_disconnect)(void);
-    void (*on_error)(const char *error);
+    // Callbacks, run on the service thread with user passed back unchanged
+    void *user;
+    void (*on_message)(void *user, const char *data, size_t len);
+    void (*on_connect)(void *user);
+    void (*on_disconnect)(void *user);
+    void (*on_error)(void *user, const char *error);
+    void (*on_tick)(void *user);
+    // Status lines, dropped when NULL
+    void (*on_log)(void *user, const char *message);
 } ws_client_t;
 
 // Initialize WebSocket client
@@ -41,22 +83,60 @@ ws_client_t* ws_client_create(const char *server, int port, const char *path);
 void ws_client_set_proxy(ws_client_t *client, const char *proxy_address, int proxy_port, 
                         const char *username, const char *password);
 
+// Set socket options applied when the connection is made
+void ws_client_set_socket_tuning(ws_client_t *client, const socket_tuning_t *tuning);
+
+// Pin the service loop thread to a CPU (-1 to disable)
+void ws_client_set_cpu_affinity(ws_client_t *client, int cpu);
+
+// Set outbound queue capacity in messages, before ws_client_connect
+void ws_client_set_send_queue_size(ws_client_t *client, int size);
+
+// Serve /metrics on 127.0.0.1:port from the client context (0 disables), before ws_client_connect
+void ws_client_set_metrics_port(ws_client_t *client, int port);
+
+// Reconnect delays in ms, doubling from initial_ms up to max_ms (initial_ms 0 disables)
+void ws_client_set_reconnect(ws_client_t *client, int initial_ms, int max_ms);
+
+// Format a status line and hand it to on_log
+void ws_client_log(const ws_client_t *client, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// Receive timestamp of the message being delivered to on_message
+int64_t ws_client_rx_timestamp(const ws_client_t *client);
+
 // Connect to WebSocket server
 int ws_client_connect(ws_client_t *client);
 
-// Send message to server
+// Queue message for sending, safe from any thread and never blocks.
+// Returns -1 when not connected, the queue is full or the message is too large.
 int ws_client_send(ws_client_t *client, const char *message);
 
+// Subscription calls below track state and must run on the service thread (callbacks)
+
 // Subscribe to stream
 int ws_client_subscribe(ws_client_t *client, const char *stream);
 
 // Unsubscribe from stream
 int ws_client_unsubscribe(ws_client_t *client, const char *stream);
 
-// Run event loop
+// Subscribe to several streams with a single SUBSCRIBE frame
+int ws_client_subscribe_batch(ws_client_t *client, const char **streams, int count);
+
+// Unsubscribe from several streams with a single UNSUBSCRIBE frame
+int ws_client_unsubscribe_batch(ws_client_t *client, const char **streams, int count);
+
+// Bring subscriptions in line with the given stream set, sending only the difference
+int ws_client_update_subscriptions(ws_client_t *client, const char **streams, int count);
+
+// Service the connection once, waiting up to timeout_ms for events, reconnect when
+// due, then run on_tick. Returns -1 once the client has been stopped.
+int ws_client_service(ws_client_t *client, int timeout_ms);
+
+// Run event loop on the calling thread until stopped
 void ws_client_run(ws_client_t *client);
 
-// Stop client
+// Stop client, safe from any thread and from signal handlers
 void ws_client_stop(ws_client_t *client);
 
 // Destroy client
@@ -0,0 +1,415 @@
+#include "analytics.h"
+#include "metrics.h"
+#include "symbol_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+analytics_t* analytics_create(int64_t window_ms, uint32_t window_trades,
+                              void (*on_update)(void *user, const analytics_snapshot_t *snapshot),
+                              void *user) {
+    analytics_t *engine = (analytics_t *)calloc(1, sizeof(analytics_t));
+    if (!engine) {
+        return NULL;
+    }
+
+    // The count window must fit in the ring next to the row being written
+    if (window_trades == 0 || window_trades >= ANALYTICS_WINDOW_MAX_CAPACITY) {
+        window_trades = ANALYTICS_WINDOW_MAX_CAPACITY - 1;
+    }
+
+    engine->window_ms = window_ms > 0 ? window_ms : 60000;
+    engine->window_trades = window_trades;
+    engine->on_update = on_update;
+    engine->user = user;
+    return engine;
+}
+
+static int lookup_symbol(const analytics_t *engine, const char *symbol, bool *found) {
+    unsigned int slot = symbol_hash(symbol, 0) & (ANALYTICS_MAX_SYMBOLS - 1);
+
+    for (int probe = 0; probe < ANALYTICS_MAX_SYMBOLS; probe++) {
+        if (!engine->in_use[slot]) {
+            *found = false;
+            return (int)slot;
+        }
+        if (strcmp(engine->symbols[slot], symbol) == 0) {
+            *found = true;
+            return (int)slot;
+        }
+        slot = (slot + 1) & (ANALYTICS_MAX_SYMBOLS - 1);
+    }
+
+    *found = false;
+    return -1;
+}
+
+static int get_symbol(analytics_t *engine, const char *symbol) {
+    bool found;
+    int slot = lookup_symbol(engine, symbol, &found);
+    if (found) {
+        return slot;
+    }
+
+    // Keep one slot free so probing always terminates
+    if (slot < 0 || engine->symbol_count >= ANALYTICS_MAX_SYMBOLS - 1) {
+        if (!engine->full_warned) {
+            fprintf(stderr, "Warning: Analytics symbol table full\n");
+            engine->full_warned = true;
+        }
+        return -1;
+    }
+
+    snprintf(engine->symbols[slot], ANALYTICS_SYMBOL_SIZE, "%s", symbol);
+    engine->in_use[slot] = true;
+    engine->symbol_count++;
+    return slot;
+}
+
+// Sum a ring column between head and tail as at most two contiguous runs
+static double ring_sum(const double *column, uint32_t capacity, uint32_t head, uint32_t tail) {
+    uint32_t count = tail - head;
+    uint32_t start = head & (capacity - 1);
+    uint32_t first = capacity - start;
+    if (first > count) {
+        first = count;
+    }
+
+    double sum = 0.0;
+    for (uint32_t i = start; i < start + first; i++) {
+        sum += column[i];
+    }
+    for (uint32_t i = 0; i < count - first; i++) {
+        sum += column[i];
+    }
+    return sum;
+}
+
+// Rebuild running sums from the rows to shed accumulated rounding error
+static void window_recompute(analytics_window_t *w) {
+    w->sum_notional = ring_sum(w->notional, w->capacity, w->head, w->tail);
+    w->sum_qty = ring_sum(w->qty, w->capacity, w->head, w->tail);
+    w->sum_signed_qty = ring_sum(w->signed_qty, w->capacity, w->head, w->tail);
+    w->sum_ret2 = ring_sum(w->ret2, w->capacity, w->head, w->tail);
+    w->count_notional = ring_sum(w->notional, w->capacity, w->count_head, w->tail);
+    w->count_qty = ring_sum(w->qty, w->capacity, w->count_head, w->tail);
+    w->appends_since_recompute = 0;
+}
+
+static void window_free(analytics_window_t *w) {
+    if (!w) {
+        return;
+    }
+    free(w->ts);
+    free(w->notional);
+    free(w->qty);
+    free(w->signed_qty);
+    free(w->ret2);
+    free(w);
+}
+
+// Double the ring, keeping row numbers; -1 at the size limit or out of memory
+static int window_grow(analytics_window_t *w) {
+    uint32_t capacity = w->capacity ? w->capacity * 2 : ANALYTICS_WINDOW_INITIAL_CAPACITY;
+    if (capacity > ANALYTICS_WINDOW_MAX_CAPACITY) {
+        return -1;
+    }
+
+    int64_t *ts = (int64_t *)malloc(sizeof(int64_t) * capacity);
+    double *notional = (double *)malloc(sizeof(double) * capacity);
+    double *qty = (double *)malloc(sizeof(double) * capacity);
+    double *signed_qty = (double *)malloc(sizeof(double) * capacity);
+    double *ret2 = (double *)malloc(sizeof(double) * capacity);
+    if (!ts || !notional || !qty || !signed_qty || !ret2) {
+        free(ts);
+        free(notional);
+        free(qty);
+        free(signed_qty);
+        free(ret2);
+        return -1;
+    }
+
+    // Rows still referenced by either window
+    uint32_t oldest = (w->tail - w->head) > (w->tail - w->count_head) ? w->head : w->count_head;
+    for (uint32_t row = oldest; row != w->tail; row++) {
+        uint32_t from = row & (w->capacity - 1);
+        uint32_t to = row & (capacity - 1);
+        ts[to] = w->ts[from];
+        notional[to] = w->notional[from];
+        qty[to] = w->qty[from];
+        signed_qty[to] = w->signed_qty[from];
+        ret2[to] = w->ret2[from];
+    }
+
+    free(w->ts);
+    free(w->notional);
+    free(w->qty);
+    free(w->signed_qty);
+    free(w->ret2);
+    w->ts = ts;
+    w->notional = notional;
+    w->qty = qty;
+    w->signed_qty = signed_qty;
+    w->ret2 = ret2;
+    w->capacity = capacity;
+    return 0;
+}
+
+static void evict_time(analytics_window_t *w) {
+    uint32_t i = w->head & (w->capacity - 1);
+    w->sum_notional -= w->notional[i];
+    w->sum_qty -= w->qty[i];
+    w->sum_signed_qty -= w->signed_qty[i];
+    w->sum_ret2 -= w->ret2[i];
+    w->head++;
+}
+
+static void evict_count(analytics_window_t *w) {
+    uint32_t i = w->count_head & (w->capacity - 1);
+    w->count_notional -= w->notional[i];
+    w->count_qty -= w->qty[i];
+    w->count_head++;
+}
+
+// Evict rows at or before cutoff from the time window, true if any left
+static bool window_expire(analytics_window_t *w, int64_t cutoff) {
+    bool evicted = false;
+    while (w->head != w->tail && w->ts[w->head & (w->capacity - 1)] <= cutoff) {
+        evict_time(w);
+        evicted = true;
+    }
+    if (evicted && w->head == w->tail) {
+        // Empty window: clear accumulated rounding error instead of reporting it
+        w->sum_notional = 0.0;
+        w->sum_qty = 0.0;
+        w->sum_signed_qty = 0.0;
+        w->sum_ret2 = 0.0;
+    }
+    return evicted;
+}
+
+static void window_append(const analytics_t *engine, const char *symbol, analytics_window_t *w,
+                          int64_t ts, double price, double qty, bool buyer_initiated) {
+    if (price <= 0.0 || qty <= 0.0) {
+        return;
+    }
+
+    // Make room for the new row in both windows
+    window_expire(w, ts - engine->window_ms);
+    while (w->tail - w->count_head >= engine->window_trades) {
+        evict_count(w);
+    }
+
+    uint32_t rows = w->tail - w->head;
+    if (w->tail - w->count_head > rows) {
+        rows = w->tail - w->count_head;
+    }
+    if (rows == w->capacity && window_grow(w) < 0) {
+        // Ring at its limit: the oldest trade leaves while still inside the time window,
+        // so the window covers less than window_ms until the rate drops
+        if (w->tail - w->head == w->capacity) {
+            evict_time(w);
+            w->overflows++;
+            metrics_inc(METRIC_ANALYTICS_WINDOW_OVERFLOWS);
+            if (w->overflows == 1) {
+                fprintf(stderr, "Warning: Analytics window of %s full at %u trades, "
+                        "covering less than %lld ms\n", symbol, w->capacity,
+                        (long long)engine->window_ms);
+            }
+        }
+        if (w->tail - w->count_head == w->capacity) {
+            evict_count(w);
+        }
+    }
+
+    double ret = w->last_price > 0.0 ? log(price / w->last_price) : 0.0;
+    w->last_price = price;
+
+    uint32_t i = w->tail & (w->capacity - 1);
+    w->ts[i] = ts;
+    w->notional[i] = price * qty;
+    w->qty[i] = qty;
+    w->signed_qty[i] = buyer_initiated ? qty : -qty;
+    w->ret2[i] = ret * ret;
+    w->tail++;
+
+    w->sum_notional += w->notional[i];
+    w->sum_qty += qty;
+    w->sum_signed_qty += w->signed_qty[i];
+    w->sum_ret2 += w->ret2[i];
+    w->count_notional += w->notional[i];
+    w->count_qty += qty;
+
+    if (++w->appends_since_recompute >= w->capacity) {
+        window_recompute(w);
+    }
+}
+
+static double ratio(double num, double den) {
+    return den > 0.0 ? num / den : 0.0;
+}
+
+static void fill_snapshot(const analytics_t *engine, int slot, analytics_snapshot_t *out) {
+    const analytics_window_t *w = engine->windows[slot];
+    double bid_qty = engine->bid_qty[slot];
+    double ask_qty = engine->ask_qty[slot];
+
+    memset(out, 0, sizeof(*out));
+    out->symbol = engine->symbols[slot];
+    out->timestamp = engine->last_ts[slot];
+    out->microprice = ratio(engine->bid_px[slot] * ask_qty + engine->ask_px[slot] * bid_qty,
+                            bid_qty + ask_qty);
+    out->top_imbalance = ratio(bid_qty - ask_qty, bid_qty + ask_qty);
+    out->book_imbalance = ratio(engine->depth_bid_qty[slot] - engine->depth_ask_qty[slot],
+                                engine->depth_bid_qty[slot] + engine->depth_ask_qty[slot]);
+
+    if (w) {
+        out->vwap = ratio(w->sum_notional, w->sum_qty);
+        out->vwap_count = ratio(w->count_notional, w->count_qty);
+        out->trade_imbalance = ratio(w->sum_signed_qty, w->sum_qty);
+        out->realized_vol = w->sum_ret2 > 0.0 ? sqrt(w->sum_ret2) : 0.0;
+        out->window_trades = w->tail - w->head;
+        out->window_overflows = w->overflows;
+    }
+}
+
+static void notify(const analytics_t *engine, int slot) {
+    if (engine->on_update) {
+        analytics_snapshot_t snapshot;
+        fill_snapshot(engine, slot, &snapshot);
+        engine->on_update(engine->user, &snapshot);
+    }
+}
+
+void analytics_update(analytics_t *engine, const market_data_t *data) {
+    if (!engine || !data || !data->symbol) {
+        return;
+    }
+
+    int slot = -1;
+
+    if (data->event == MARKET_EVENT_AGG_TRADE) {
+        slot = get_symbol(engine, data->symbol);
+        if (slot < 0) {
+            return;
+        }
+        if (!engine->windows[slot]) {
+            engine->windows[slot] = (analytics_window_t *)calloc(1, sizeof(analytics_window_t));
+            if (!engine->windows[slot]) {
+                return;
+            }
+        }
+        window_append(engine, engine->symbols[slot], engine->windows[slot], data->timestamp,
+                      data->price, data->quantity, !data->is_buyer_maker);
+    } else if (data->event == MARKET_EVENT_BOOK_TICKER) {
+        if (data->bid_count < 1 || data->ask_count < 1 ||
+            !data->bid_quantities || !data->ask_quantities) {
+            return;
+        }
+        slot = get_symbol(engine, data->symbol);
+        if (slot < 0) {
+            return;
+        }
+        engine->bid_px[slot] = data->bid_prices[0];
+        engine->bid_qty[slot] = data->bid_quantities[0];
+        engine->ask_px[slot] = data->ask_prices[0];
+        engine->ask_qty[slot] = data->ask_quantities[0];
+    } else {
+        return;
+    }
+
+    if (data->timestamp > engine->last_ts[slot]) {
+        engine->last_ts[slot] = data->timestamp;
+    }
+    notify(engine, slot);
+}
+
+void analytics_update_book(analytics_t *engine, const char *symbol, const order_book_t *book,
+                           int64_t timestamp) {
+    // Depth diffs alone are not a book, only a synchronized one gives the top levels
+    if (!engine || !symbol || !book) {
+        return;
+    }
+
+    int slot = get_symbol(engine, symbol);
+    if (slot < 0) {
+        return;
+    }
+
+    double bid_qty = 0.0, ask_qty = 0.0;
+    for (int i = 0; i < book->bids.count && i < ANALYTICS_DEPTH_LEVELS; i++) {
+        bid_qty += book->bids.quantities[i];
+    }
+    for (int i = 0; i < book->asks.count && i < ANALYTICS_DEPTH_LEVELS; i++) {
+        ask_qty += book->asks.quantities[i];
+    }
+    engine->depth_bid_qty[slot] = bid_qty;
+    engine->depth_ask_qty[slot] = ask_qty;
+
+    if (timestamp > engine->last_ts[slot]) {
+        engine->last_ts[slot] = timestamp;
+    }
+    notify(engine, slot);
+}
+
+void analytics_expire(analytics_t *engine, int64_t now_ms) {
+    if (!engine) {
+        return;
+    }
+
+    int64_t cutoff = now_ms - engine->window_ms;
+    for (int i = 0; i < ANALYTICS_MAX_SYMBOLS; i++) {
+        if (engine->windows[i] && window_expire(engine->windows[i], cutoff)) {
+            notify(engine, i);
+        }
+    }
+}
+
+int analytics_snapshot(const analytics_t *engine, const char *symbol, analytics_snapshot_t *out) {
+    if (!engine || !symbol || !out) {
+        return -1;
+    }
+
+    bool found;
+    int slot = lookup_symbol(engine, symbol, &found);
+    if (!found) {
+        return -1;
+    }
+
+    fill_snapshot(engine, slot, out);
+    return 0;
+}
+
+void analytics_print(const analytics_t *engine) {
+    if (!engine) {
+        return;
+    }
+
+    printf("\n=== Analytics ===\n");
+    for (int i = 0; i < ANALYTICS_MAX_SYMBOLS; i++) {
+        if (!engine->in_use[i]) {
+            continue;
+        }
+        analytics_snapshot_t snapshot;
+        fill_snapshot(engine, i, &snapshot);
+        printf("%-12s vwap=%.8f vwap_n=%.8f micro=%.8f top_imb=%+.4f book_imb=%+.4f "
+               "flow_imb=%+.4f rvol=%.6f trades=%u overflows=%llu\n",
+               snapshot.symbol, snapshot.vwap, snapshot.vwap_count, snapshot.microprice,
+               snapshot.top_imbalance, snapshot.book_imbalance, snapshot.trade_imbalance,
+               snapshot.realized_vol, snapshot.window_trades,
+               (unsigned long long)snapshot.window_overflows);
+    }
+    printf("=================\n");
+}
+
+void analytics_destroy(analytics_t *engine) {
+    if (!engine) {
+        return;
+    }
+
+    for (int i = 0; i < ANALYTICS_MAX_SYMBOLS; i++) {
+        window_free(engine->windows[i]);
+    }
+    free(engine);
+}
\ No newline at end of file
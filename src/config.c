@@ -0,0 +1,293 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <libgen.h>
+#endif
+
+#define CONFIG_LINE_SIZE 1024
+
+void config_init(app_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->use_proxy = false;
+    config->proxy_port = 7890;
+    config->sink = SINK_STDOUT;
+    config->store_dir = strdup("data");
+    config->send_queue_size = 64;
+    config->cpu_affinity = -1;
+    config->depth_books = false;
+    config->rest_host = strdup("fapi.binance.com");
+    config->rest_port = 443;
+    config->rest_tls = true;
+    config->depth_snapshot_limit = 1000;
+    config->rest_max_in_flight = 10;
+    config->rest_weight_limit = 2400;
+    config->event_merge = false;
+    config->merge_window_ms = 20;
+    config->merge_max_lateness_ms = 0;
+    config->merge_capacity = 4096;
+    config->metrics_port = 0;
+    config->metrics_log_interval = 0;
+    config->parser_check = false;
+    config->analytics = false;
+    config->analytics_window_ms = 60000;
+    config->analytics_window_trades = 1000;
+}
+
+static bool parse_bool(const char *value) {
+    return strcmp(value, "true") == 0 || strcmp(value, "1") == 0;
+}
+
+static void replace_string(char **dst, const char *value) {
+    free(*dst);
+    *dst = strdup(value);
+}
+
+int config_add_stream(app_config_t *config, const char *stream) {
+    if (!stream || stream[0] == '\0') {
+        return -1;
+    }
+
+    for (int i = 0; i < config->stream_count; i++) {
+        if (strcmp(config->streams[i], stream) == 0) {
+            return 0;
+        }
+    }
+
+    if (config->stream_count >= CONFIG_MAX_STREAMS) {
+        fprintf(stderr, "Warning: Too many streams, ignoring %s\n", stream);
+        return -1;
+    }
+
+    config->streams[config->stream_count++] = strdup(stream);
+    return 0;
+}
+
+int config_parse_sink(const char *name, sink_type_t *sink) {
+    if (strcmp(name, "stdout") == 0) {
+        *sink = SINK_STDOUT;
+    } else if (strcmp(name, "store") == 0) {
+        *sink = SINK_STORE;
+    } else if (strcmp(name, "none") == 0) {
+        *sink = SINK_NONE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int config_load_file(const char *filename, app_config_t *config) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Warning: Cannot open config file: %s\n", filename);
+        return -1;
+    }
+
+    char line[CONFIG_LINE_SIZE];
+    while (fgets(line, sizeof(line), file)) {
+        // Remove newline
+        line[strcspn(line, "\r\n")] = 0;
+
+        // Skip comments and empty lines
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+
+        char key[64], value[CONFIG_LINE_SIZE];
+        if (sscanf(line, "%63[^=]=%1023s", key, value) != 2) {
+            continue;
+        }
+
+        if (strcmp(key, "use_proxy") == 0) {
+            config->use_proxy = parse_bool(value);
+        } else if (strcmp(key, "proxy_address") == 0) {
+            replace_string(&config->proxy_address, value);
+        } else if (strcmp(key, "proxy_port") == 0) {
+            config->proxy_port = atoi(value);
+        } else if (strcmp(key, "proxy_username") == 0) {
+            replace_string(&config->proxy_username, value);
+        } else if (strcmp(key, "proxy_password") == 0) {
+            replace_string(&config->proxy_password, value);
+        } else if (strcmp(key, "stream") == 0) {
+            config_add_stream(config, value);
+        } else if (strcmp(key, "streams") == 0) {
+            // Comma separated stream list
+            char *saveptr = NULL;
+            for (char *tok = strtok_r(value, ",", &saveptr); tok;
+                 tok = strtok_r(NULL, ",", &saveptr)) {
+                config_add_stream(config, tok);
+            }
+        } else if (strcmp(key, "sink") == 0) {
+            if (config_parse_sink(value, &config->sink) < 0) {
+                fprintf(stderr, "Warning: Unknown sink: %s\n", value);
+            }
+        } else if (strcmp(key, "store_dir") == 0) {
+            replace_string(&config->store_dir, value);
+        } else if (strcmp(key, "send_queue_size") == 0) {
+            int size = atoi(value);
+            if (size > 0) {
+                config->send_queue_size = size;
+            }
+        } else if (strcmp(key, "parser_check") == 0) {
+            config->parser_check = parse_bool(value);
+        } else if (strcmp(key, "analytics") == 0) {
+            config->analytics = parse_bool(value);
+        } else if (strcmp(key, "analytics_window_ms") == 0) {
+            config->analytics_window_ms = atoi(value);
+        } else if (strcmp(key, "analytics_window_trades") == 0) {
+            config->analytics_window_trades = atoi(value);
+        } else if (strcmp(key, "so_rcvbuf") == 0) {
+            config->socket.rcvbuf = atoi(value);
+        } else if (strcmp(key, "tcp_nodelay") == 0) {
+            config->socket.tcp_nodelay = parse_bool(value);
+        } else if (strcmp(key, "so_busy_poll") == 0) {
+            config->socket.busy_poll_us = atoi(value);
+        } else if (strcmp(key, "tcp_quickack") == 0) {
+            config->socket.tcp_quickack = parse_bool(value);
+        } else if (strcmp(key, "so_timestamping") == 0) {
+            config->socket.rx_timestamping = parse_bool(value);
+        } else if (strcmp(key, "cpu_affinity") == 0) {
+            config->cpu_affinity = atoi(value);
+        } else if (strcmp(key, "depth_books") == 0) {
+            config->depth_books = parse_bool(value);
+        } else if (strcmp(key, "rest_host") == 0) {
+            replace_string(&config->rest_host, value);
+        } else if (strcmp(key, "rest_port") == 0) {
+            config->rest_port = atoi(value);
+        } else if (strcmp(key, "rest_tls") == 0) {
+            config->rest_tls = parse_bool(value);
+        } else if (strcmp(key, "depth_snapshot_limit") == 0) {
+            config->depth_snapshot_limit = atoi(value);
+        } else if (strcmp(key, "rest_max_in_flight") == 0) {
+            config->rest_max_in_flight = atoi(value);
+        } else if (strcmp(key, "rest_weight_limit") == 0) {
+            config->rest_weight_limit = atoi(value);
+        } else if (strcmp(key, "event_merge") == 0) {
+            config->event_merge = parse_bool(value);
+        } else if (strcmp(key, "merge_window_ms") == 0) {
+            config->merge_window_ms = atoi(value);
+        } else if (strcmp(key, "merge_max_lateness_ms") == 0) {
+            config->merge_max_lateness_ms = atoi(value);
+        } else if (strcmp(key, "merge_capacity") == 0) {
+            config->merge_capacity = atoi(value);
+        } else if (strcmp(key, "metrics_port") == 0) {
+            config->metrics_port = atoi(value);
+        } else if (strcmp(key, "metrics_log_interval") == 0) {
+            config->metrics_log_interval = atoi(value);
+        } else {
+            fprintf(stderr, "Warning: Unknown config key: %s\n", key);
+        }
+    }
+
+    fclose(file);
+    printf("Configuration loaded from %s\n", filename);
+    return 0;
+}
+
+void config_free(app_config_t *config) {
+    free(config->proxy_address);
+    free(config->proxy_username);
+    free(config->proxy_password);
+    free(config->store_dir);
+    free(config->rest_host);
+
+    for (int i = 0; i < config->stream_count; i++) {
+        free(config->streams[i]);
+    }
+
+    memset(config, 0, sizeof(*config));
+}
+
+static bool string_changed(const char *a, const char *b) {
+    if (!a || !b) {
+        return a != b;
+    }
+    return strcmp(a, b) != 0;
+}
+
+bool config_needs_restart(const app_config_t *current, const app_config_t *next) {
+    return next->use_proxy != current->use_proxy ||
+           string_changed(next->proxy_address, current->proxy_address) ||
+           next->proxy_port != current->proxy_port ||
+           next->send_queue_size != current->send_queue_size ||
+           memcmp(&next->socket, &current->socket, sizeof(next->socket)) != 0 ||
+           next->cpu_affinity != current->cpu_affinity ||
+           next->metrics_port != current->metrics_port ||
+           next->depth_books != current->depth_books ||
+           string_changed(next->rest_host, current->rest_host) ||
+           next->rest_port != current->rest_port ||
+           next->event_merge != current->event_merge ||
+           next->merge_window_ms != current->merge_window_ms ||
+           next->merge_max_lateness_ms != current->merge_max_lateness_ms ||
+           next->merge_capacity != current->merge_capacity ||
+           next->analytics != current->analytics ||
+           next->analytics_window_ms != current->analytics_window_ms ||
+           next->analytics_window_trades != current->analytics_window_trades;
+}
+
+#ifdef __linux__
+int config_watch(const char *filename) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Watch the directory so editors that replace the file are caught too
+    char *path = strdup(filename);
+    if (!path) {
+        close(fd);
+        return -1;
+    }
+    int wd = inotify_add_watch(fd, dirname(path), IN_CLOSE_WRITE | IN_MOVED_TO);
+    free(path);
+
+    if (wd < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool config_watch_changed(int watch_fd, const char *filename) {
+    if (watch_fd < 0) {
+        return false;
+    }
+
+    char *path = strdup(filename);
+    if (!path) {
+        return false;
+    }
+    const char *name = basename(path);
+
+    bool changed = false;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    while ((n = read(watch_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0 && strcmp(event->name, name) == 0) {
+                changed = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    free(path);
+    return changed;
+}
+#else
+int config_watch(const char *filename) {
+    (void)filename;
+    return -1;
+}
+
+bool config_watch_changed(int watch_fd, const char *filename) {
+    (void)watch_fd;
+    (void)filename;
+    return false;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,620 @@
+#include "cryptostream.h"
+#include "ws_client.h"
+#include "depth_sync.h"
+#include "event_merger.h"
+#include "sequence.h"
+#include "analytics.h"
+#include "tick_store.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define PARSER_MISMATCHES_LOGGED 10
+
+#define STRINGIFY(x) #x
+#define VERSION_STRING(major, minor, patch) STRINGIFY(major) "." STRINGIFY(minor) "." STRINGIFY(patch)
+
+struct cryptostream {
+    ws_client_t *client;
+    cryptostream_callbacks_t callbacks;
+    void *user;
+
+    // Wanted streams, replaced from any thread under the lock
+    pthread_mutex_t lock;
+    char *pending[MAX_SUBSCRIPTIONS];
+    int pending_count;
+    atomic_bool pending_changed;
+
+    // Streams in effect, owned by the service thread
+    char *streams[MAX_SUBSCRIPTIONS];
+    int stream_count;
+    market_parser_fn parser;
+
+    // Order books, created with the context on connect
+    bool depth_books;
+    char *rest_host;
+    int rest_port;
+    bool rest_tls;
+    int snapshot_limit;
+    int max_in_flight;
+    int weight_per_minute;
+    depth_sync_t *books;
+
+    // Event time ordering across streams, owned by the caller
+    event_merger_t *merger;
+
+    // Exchange ids per symbol and stream, checked before anything else sees the event
+    seq_tracker_t *sequence;
+
+    // Optional comparison with the reference parser, counters owned by the service thread
+    atomic_bool parser_check;
+    unsigned long parser_checked;
+    unsigned long parser_mismatches;
+
+    // Managed mode service thread
+    pthread_t thread;
+    bool thread_started;
+};
+
+const char* cryptostream_version(void) {
+    return VERSION_STRING(CRYPTOSTREAM_VERSION_MAJOR, CRYPTOSTREAM_VERSION_MINOR,
+                          CRYPTOSTREAM_VERSION_PATCH);
+}
+
+static void free_streams(char **streams, int count) {
+    for (int i = 0; i < count; i++) {
+        free(streams[i]);
+    }
+}
+
+// Take over the latest wanted stream set, on the service thread. True if it changed.
+static bool apply_streams(cryptostream_t *stream) {
+    if (!atomic_load_explicit(&stream->pending_changed, memory_order_acquire)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    free_streams(stream->streams, stream->stream_count);
+    memcpy(stream->streams, stream->pending, sizeof(char *) * (size_t)stream->pending_count);
+    stream->stream_count = stream->pending_count;
+    stream->pending_count = 0;
+    atomic_store_explicit(&stream->pending_changed, false, memory_order_relaxed);
+    pthread_mutex_unlock(&stream->lock);
+
+    // Pick the parser for the stream set once, not per message
+    stream->parser = market_parser_for_streams((const char **)stream->streams, stream->stream_count);
+    if (stream->parser != parse_market_data) {
+        ws_client_log(stream->client, "Using parser specialized for %s streams", stream->streams[0]);
+    }
+
+    // New depth streams get books, books of removed streams are freed
+    if (stream->books) {
+        depth_sync_track_streams(stream->books, (const char **)stream->streams, stream->stream_count);
+    }
+    return true;
+}
+
+static void handle_sequence(void *user, const seq_event_t *event) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    metrics_inc(METRIC_SEQUENCE_ANOMALIES);
+    // Diffs after a hole cannot be applied to the book, start over from a snapshot
+    if (event->status == SEQ_GAP && event->type == SEQ_STREAM_DEPTH &&
+        depth_sync_resync(stream->books, event->symbol) == 0) {
+        ws_client_log(stream->client, "Depth gap on %s, fetching snapshot", event->symbol);
+    }
+
+    if (stream->callbacks.on_sequence) {
+        stream->callbacks.on_sequence(stream->user, event);
+    }
+}
+
+// Compare a parse result with the reference parser, log the first differing field
+static void check_parser(cryptostream_t *stream, const market_data_t *market_data,
+                         const char *data, size_t len) {
+    market_data_t *reference = parse_market_data_reference(data, len);
+    const char *field = market_data_compare(market_data, reference);
+    stream->parser_checked++;
+    if (field && ++stream->parser_mismatches <= PARSER_MISMATCHES_LOGGED) {
+        ws_client_log(stream->client, "Parser mismatch in %s: %.*s", field,
+                      (int)(len < 400 ? len : 400), data);
+    }
+    free_market_data(reference);
+}
+
+static void handle_message(void *user, const char *data, size_t len) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    if (stream->callbacks.on_message) {
+        stream->callbacks.on_message(stream->user, data, len);
+    }
+    if (!stream->callbacks.on_market_data && !stream->callbacks.on_sequence && !stream->books &&
+        !stream->merger) {
+        return;
+    }
+
+    market_data_t *market_data = stream->parser(data, len);
+    if (!market_data) {
+        metrics_inc(METRIC_PARSE_FAILURES);
+        return;
+    }
+
+    market_data->receive_time_ns = ws_client_rx_timestamp(stream->client);
+    if (market_data->event != MARKET_EVENT_NONE &&
+        atomic_load_explicit(&stream->parser_check, memory_order_relaxed)) {
+        check_parser(stream, market_data, data, len);
+    }
+    seq_tracker_check(stream->sequence, market_data);
+    depth_sync_update(stream->books, market_data);
+    if (stream->callbacks.on_market_data) {
+        stream->callbacks.on_market_data(stream->user, market_data, data, len);
+    }
+    metrics_record_stream(market_data->symbol, market_data->event, len);
+
+    // An attached merger takes the event over and releases it in exchange time order
+    if (stream->merger) {
+        event_merger_push(stream->merger, market_data, metrics_clock_ns());
+    } else {
+        free_market_data(market_data);
+    }
+}
+
+static void handle_connect(void *user) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    if (stream->callbacks.on_connect) {
+        stream->callbacks.on_connect(stream->user);
+    }
+
+    // Subscribe to all wanted streams in one batch
+    apply_streams(stream);
+    ws_client_log(stream->client, "Subscribing to %d streams...", stream->stream_count);
+    ws_client_update_subscriptions(stream->client, (const char **)stream->streams,
+                                   stream->stream_count);
+}
+
+static void handle_disconnect(void *user) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    // Books continue from fresh snapshots once diffs flow again, ids from the next message
+    depth_sync_reset_all(stream->books);
+    seq_tracker_reset_all(stream->sequence);
+    // Events of the lost connection go out before the disconnect is reported,
+    // not interleaved with those of the next one
+    event_merger_flush(stream->merger);
+
+    if (stream->callbacks.on_disconnect) {
+        stream->callbacks.on_disconnect(stream->user);
+    }
+}
+
+static void handle_error(void *user, const char *error) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    if (stream->callbacks.on_error) {
+        stream->callbacks.on_error(stream->user, error);
+    }
+}
+
+static void handle_log(void *user, const char *message) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    if (stream->callbacks.on_log) {
+        stream->callbacks.on_log(stream->user, message);
+    }
+}
+
+static void handle_tick(void *user) {
+    cryptostream_t *stream = (cryptostream_t *)user;
+
+    depth_sync_pump(stream->books);
+    // Events that waited out the window while no newer ones arrived
+    event_merger_drain(stream->merger, metrics_clock_ns());
+
+    if (stream->callbacks.on_tick) {
+        stream->callbacks.on_tick(stream->user);
+    }
+
+    // Stream changes from any thread, including on_tick above, go out from here
+    if (apply_streams(stream) && stream->client->connected) {
+        ws_client_update_subscriptions(stream->client, (const char **)stream->streams,
+                                       stream->stream_count);
+    }
+}
+
+cryptostream_t* cryptostream_create(const char *host, int port, const char *path) {
+    if (!host || !path) {
+        return NULL;
+    }
+
+    cryptostream_t *stream = (cryptostream_t *)calloc(1, sizeof(cryptostream_t));
+    if (!stream) {
+        return NULL;
+    }
+
+    stream->client = ws_client_create(host, port, path);
+    stream->sequence = seq_tracker_create(handle_sequence, stream);
+    if (!stream->client || !stream->sequence) {
+        ws_client_destroy(stream->client);
+        seq_tracker_destroy(stream->sequence);
+        free(stream);
+        return NULL;
+    }
+
+    pthread_mutex_init(&stream->lock, NULL);
+    atomic_init(&stream->pending_changed, false);
+    atomic_init(&stream->parser_check, false);
+    stream->parser = parse_market_data;
+
+    stream->client->user = stream;
+    stream->client->on_message = handle_message;
+    stream->client->on_connect = handle_connect;
+    stream->client->on_disconnect = handle_disconnect;
+    stream->client->on_error = handle_error;
+    stream->client->on_tick = handle_tick;
+    stream->client->on_log = handle_log;
+    return stream;
+}
+
+void cryptostream_set_callbacks(cryptostream_t *stream, const cryptostream_callbacks_t *callbacks,
+                                void *user) {
+    if (!stream) {
+        return;
+    }
+
+    if (callbacks) {
+        stream->callbacks = *callbacks;
+    } else {
+        memset(&stream->callbacks, 0, sizeof(stream->callbacks));
+    }
+    stream->user = user;
+}
+
+void cryptostream_set_proxy(cryptostream_t *stream, const char *address, int port,
+                            const char *username, const char *password) {
+    if (!stream) {
+        return;
+    }
+    ws_client_set_proxy(stream->client, address, port, username, password);
+}
+
+void cryptostream_set_socket_tuning(cryptostream_t *stream, const socket_tuning_t *tuning) {
+    if (!stream) {
+        return;
+    }
+    ws_client_set_socket_tuning(stream->client, tuning);
+}
+
+void cryptostream_set_cpu_affinity(cryptostream_t *stream, int cpu) {
+    if (!stream) {
+        return;
+    }
+    ws_client_set_cpu_affinity(stream->client, cpu);
+}
+
+void cryptostream_set_send_queue_size(cryptostream_t *stream, int size) {
+    if (!stream) {
+        return;
+    }
+    ws_client_set_send_queue_size(stream->client, size);
+}
+
+void cryptostream_set_metrics_port(cryptostream_t *stream, int port) {
+    if (!stream) {
+        return;
+    }
+    ws_client_set_metrics_port(stream->client, port);
+}
+
+void cryptostream_set_reconnect(cryptostream_t *stream, int initial_ms, int max_ms) {
+    if (!stream) {
+        return;
+    }
+    ws_client_set_reconnect(stream->client, initial_ms, max_ms);
+}
+
+int cryptostream_set_depth_books(cryptostream_t *stream, const char *rest_host, int rest_port,
+                                 bool rest_tls, int snapshot_limit, int max_in_flight,
+                                 int weight_per_minute) {
+    if (!stream || !rest_host) {
+        return -1;
+    }
+
+    char *host = strdup(rest_host);
+    if (!host) {
+        return -1;
+    }
+
+    free(stream->rest_host);
+    stream->rest_host = host;
+    stream->rest_port = rest_port;
+    stream->rest_tls = rest_tls;
+    stream->snapshot_limit = snapshot_limit;
+    stream->max_in_flight = max_in_flight;
+    stream->weight_per_minute = weight_per_minute;
+    stream->depth_books = true;
+    return 0;
+}
+
+event_merger_t* cryptostream_merger_create(
+    int window_ms, int max_lateness_ms, size_t capacity,
+    void (*on_event)(void *user, const market_data_t *data, bool late), void *user) {
+    if (!on_event) {
+        return NULL;
+    }
+    return event_merger_create(window_ms, max_lateness_ms, capacity, on_event, user);
+}
+
+void cryptostream_merger_flush(event_merger_t *merger) {
+    event_merger_flush(merger);
+}
+
+void cryptostream_merger_print(event_merger_t *merger) {
+    event_merger_print(merger);
+}
+
+void cryptostream_merger_destroy(event_merger_t *merger) {
+    event_merger_destroy(merger);
+}
+
+void cryptostream_set_merger(cryptostream_t *stream, event_merger_t *merger) {
+    if (!stream) {
+        return;
+    }
+    stream->merger = merger;
+}
+
+int cryptostream_set_streams(cryptostream_t *stream, const char **streams, int count) {
+    if (!stream || count < 0 || (count > 0 && !streams)) {
+        return -1;
+    }
+    if (count > MAX_SUBSCRIPTIONS) {
+        fprintf(stderr, "Too many streams: %d (max %d)\n", count, MAX_SUBSCRIPTIONS);
+        return -1;
+    }
+
+    // Copy outside the lock so the service thread is never held up by allocation
+    char *copies[MAX_SUBSCRIPTIONS];
+    for (int i = 0; i < count; i++) {
+        copies[i] = strdup(streams[i]);
+        if (!copies[i]) {
+            free_streams(copies, i);
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    free_streams(stream->pending, stream->pending_count);
+    memcpy(stream->pending, copies, sizeof(char *) * (size_t)count);
+    stream->pending_count = count;
+    atomic_store_explicit(&stream->pending_changed, true, memory_order_release);
+    pthread_mutex_unlock(&stream->lock);
+
+    // Cut the current service wait short so the change goes out with the next tick
+    if (stream->client->context) {
+        lws_cancel_service(stream->client->context);
+    }
+    return 0;
+}
+
+void cryptostream_set_parser_check(cryptostream_t *stream, bool enabled) {
+    if (!stream) {
+        return;
+    }
+    atomic_store_explicit(&stream->parser_check, enabled, memory_order_relaxed);
+}
+
+int cryptostream_send(cryptostream_t *stream, const char *message) {
+    if (!stream || !message) {
+        return -1;
+    }
+    return ws_client_send(stream->client, message);
+}
+
+int cryptostream_connect(cryptostream_t *stream) {
+    if (!stream) {
+        return -1;
+    }
+
+    // Nothing services the stream yet, so the caller thread may take the stream set over
+    apply_streams(stream);
+
+    if (ws_client_connect(stream->client) < 0) {
+        return -1;
+    }
+
+    // Depth snapshots are fetched over REST on the same context while diffs buffer
+    if (stream->depth_books && !stream->books) {
+        stream->books = depth_sync_create(stream->client->context, stream->rest_host,
+                                          stream->rest_port, stream->rest_tls,
+                                          stream->snapshot_limit, stream->max_in_flight,
+                                          stream->weight_per_minute);
+        if (stream->books) {
+            stream->books->on_log = handle_log;
+            stream->books->log_user = stream;
+            depth_sync_track_streams(stream->books, (const char **)stream->streams,
+                                     stream->stream_count);
+            ws_client_log(stream->client, "Building %d order books from %s:%d snapshots",
+                          stream->books->symbol_count, stream->rest_host, stream->rest_port);
+        } else {
+            fprintf(stderr, "Order books disabled: REST client could not be created\n");
+        }
+    }
+    return 0;
+}
+
+int cryptostream_poll(cryptostream_t *stream, int timeout_ms) {
+    if (!stream) {
+        return -1;
+    }
+    return ws_client_service(stream->client, timeout_ms);
+}
+
+void cryptostream_run(cryptostream_t *stream) {
+    if (!stream) {
+        return;
+    }
+    ws_client_run(stream->client);
+}
+
+static void* service_thread(void *arg) {
+    cryptostream_t *stream = (cryptostream_t *)arg;
+    ws_client_run(stream->client);
+    free_parser_thread_state();
+    return NULL;
+}
+
+int cryptostream_start(cryptostream_t *stream) {
+    if (!stream || !stream->client->context) {
+        fprintf(stderr, "Stream must be connected before it is started\n");
+        return -1;
+    }
+    if (stream->thread_started) {
+        return 0;
+    }
+
+    if (pthread_create(&stream->thread, NULL, service_thread, stream) != 0) {
+        fprintf(stderr, "Failed to start service thread\n");
+        return -1;
+    }
+    stream->thread_started = true;
+    return 0;
+}
+
+void cryptostream_stop(cryptostream_t *stream) {
+    if (!stream) {
+        return;
+    }
+    ws_client_stop(stream->client);
+}
+
+void cryptostream_join(cryptostream_t *stream) {
+    if (!stream || !stream->thread_started) {
+        return;
+    }
+    pthread_join(stream->thread, NULL);
+    stream->thread_started = false;
+}
+
+bool cryptostream_connected(const cryptostream_t *stream) {
+    return stream && stream->client->connected;
+}
+
+const order_book_t* cryptostream_book(const cryptostream_t *stream, const char *symbol) {
+    if (!stream) {
+        return NULL;
+    }
+    return depth_sync_book(stream->books, symbol);
+}
+
+void cryptostream_print_books(const cryptostream_t *stream) {
+    if (!stream) {
+        return;
+    }
+    depth_sync_print(stream->books);
+}
+
+const seq_stream_t* cryptostream_sequence(const cryptostream_t *stream, const char *symbol,
+                                          seq_stream_type_t type) {
+    if (!stream) {
+        return NULL;
+    }
+    return seq_tracker_find(stream->sequence, symbol, type);
+}
+
+void cryptostream_print_sequence(const cryptostream_t *stream) {
+    if (!stream) {
+        return;
+    }
+    seq_tracker_print(stream->sequence);
+}
+
+const char* cryptostream_sequence_type_name(seq_stream_type_t type) {
+    return seq_stream_type_name(type);
+}
+
+void cryptostream_print_parser_check(const cryptostream_t *stream) {
+    if (!stream || stream->parser_checked == 0) {
+        return;
+    }
+    printf("Parser check: %lu messages, %lu mismatches\n", stream->parser_checked,
+           stream->parser_mismatches);
+}
+
+void cryptostream_print_market_data(const market_data_t *data) {
+    print_market_data(data);
+}
+
+analytics_t* cryptostream_analytics_create(
+    int64_t window_ms, uint32_t window_trades,
+    void (*on_update)(void *user, const analytics_snapshot_t *snapshot), void *user) {
+    return analytics_create(window_ms, window_trades, on_update, user);
+}
+
+void cryptostream_analytics_update(analytics_t *engine, const market_data_t *data) {
+    analytics_update(engine, data);
+}
+
+void cryptostream_analytics_update_book(analytics_t *engine, const char *symbol,
+                                        const order_book_t *book, int64_t timestamp) {
+    analytics_update_book(engine, symbol, book, timestamp);
+}
+
+void cryptostream_analytics_expire(analytics_t *engine, int64_t now_ms) {
+    analytics_expire(engine, now_ms);
+}
+
+void cryptostream_analytics_print(const analytics_t *engine) {
+    analytics_print(engine);
+}
+
+void cryptostream_analytics_destroy(analytics_t *engine) {
+    analytics_destroy(engine);
+}
+
+tick_store_t* cryptostream_store_open(const char *root_dir) {
+    return tick_store_open(root_dir);
+}
+
+int cryptostream_store_append(tick_store_t *store, const market_data_t *data) {
+    return tick_store_append_market_data(store, data);
+}
+
+int cryptostream_store_sync(tick_store_t *store) {
+    return tick_store_sync(store);
+}
+
+void cryptostream_store_close(tick_store_t *store) {
+    tick_store_close(store);
+}
+
+void cryptostream_metrics_log(FILE *out) {
+    metrics_log_line(out);
+}
+
+void cryptostream_metrics_shutdown(void) {
+    metrics_shutdown();
+}
+
+void cryptostream_destroy(cryptostream_t *stream) {
+    if (!stream) {
+        return;
+    }
+
+    cryptostream_stop(stream);
+    cryptostream_join(stream);
+
+    // Context teardown may still complete snapshot requests into the books
+    ws_client_destroy(stream->client);
+    depth_sync_destroy(stream->books);
+    seq_tracker_destroy(stream->sequence);
+
+    free_streams(stream->pending, stream->pending_count);
+    free_streams(stream->streams, stream->stream_count);
+    free(stream->rest_host);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream);
+}
\ No newline at end of file
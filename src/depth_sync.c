@@ -0,0 +1,552 @@
+#include "depth_sync.h"
+#include "metrics.h"
+#include "symbol_hash.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYMBOL_MASK (DEPTH_SYNC_MAX_SYMBOLS - 1)
+#define RING_MASK (DEPTH_SYNC_RING - 1)
+
+static void on_snapshot(void *ctx, const char *symbol, int status, const char *body, size_t len);
+
+depth_sync_t* depth_sync_create(struct lws_context *context, const char *rest_host, int rest_port,
+                                bool rest_tls, int snapshot_limit, int max_in_flight,
+                                int weight_per_minute) {
+    depth_sync_t *sync = (depth_sync_t *)calloc(1, sizeof(depth_sync_t));
+    if (!sync) {
+        return NULL;
+    }
+
+    sync->fetcher = snapshot_fetcher_create(context, rest_host, rest_port, rest_tls, snapshot_limit,
+                                            max_in_flight, weight_per_minute, on_snapshot, sync);
+    if (!sync->fetcher) {
+        free(sync);
+        return NULL;
+    }
+    return sync;
+}
+
+static int lookup_symbol(const depth_sync_t *sync, const char *symbol, bool *found) {
+    unsigned int slot = symbol_hash(symbol, 0) & SYMBOL_MASK;
+
+    for (int probe = 0; probe < DEPTH_SYNC_MAX_SYMBOLS; probe++) {
+        if (!sync->symbols[slot]) {
+            *found = false;
+            return (int)slot;
+        }
+        if (strcmp(sync->symbols[slot]->symbol, symbol) == 0) {
+            *found = true;
+            return (int)slot;
+        }
+        slot = (slot + 1) & SYMBOL_MASK;
+    }
+
+    *found = false;
+    return -1;
+}
+
+static depth_symbol_t* find_symbol(const depth_sync_t *sync, const char *symbol) {
+    bool found;
+    int slot = lookup_symbol(sync, symbol, &found);
+    return found ? sync->symbols[slot] : NULL;
+}
+
+// Start the consistency clock when the first book falls out of sync
+static void mark_unsynced(depth_sync_t *sync) {
+    if (!sync->sync_started_ns) {
+        sync->sync_started_ns = metrics_clock_ns();
+    }
+    metrics_gauge_set(METRIC_BOOKS_LIVE, sync->live_count);
+}
+
+int depth_sync_track(depth_sync_t *sync, const char *symbol) {
+    if (!sync || !symbol || !*symbol) {
+        return -1;
+    }
+
+    bool found;
+    int slot = lookup_symbol(sync, symbol, &found);
+    if (found) {
+        return 0;
+    }
+
+    // Keep one slot free so probing always terminates
+    if (slot < 0 || sync->symbol_count >= DEPTH_SYNC_MAX_SYMBOLS - 1) {
+        if (!sync->full_warned) {
+            fprintf(stderr, "Warning: Order book table full, %s not tracked\n", symbol);
+            sync->full_warned = true;
+        }
+        return -1;
+    }
+
+    depth_symbol_t *entry = (depth_symbol_t *)calloc(1, sizeof(depth_symbol_t));
+    if (!entry) {
+        return -1;
+    }
+    snprintf(entry->symbol, sizeof(entry->symbol), "%s", symbol);
+    entry->state = BOOK_WAIT_SNAPSHOT;
+
+    sync->symbols[slot] = entry;
+    sync->symbol_count++;
+    mark_unsynced(sync);
+    return 0;
+}
+
+static void free_symbol(depth_symbol_t *entry) {
+    if (entry->ring) {
+        for (int j = 0; j < DEPTH_SYNC_RING; j++) {
+            free(entry->ring[j].bid_prices);
+            free(entry->ring[j].bid_quantities);
+            free(entry->ring[j].ask_prices);
+            free(entry->ring[j].ask_quantities);
+        }
+        free(entry->ring);
+    }
+    order_book_free(&entry->book);
+    free(entry);
+}
+
+// Empty a slot, moving later entries of its probe run back into the hole so
+// lookups never stop early at it
+static void remove_slot(depth_sync_t *sync, unsigned int slot) {
+    unsigned int hole = slot;
+    unsigned int next = (hole + 1) & SYMBOL_MASK;
+    sync->symbols[hole] = NULL;
+
+    while (sync->symbols[next]) {
+        unsigned int home = symbol_hash(sync->symbols[next]->symbol, 0) & SYMBOL_MASK;
+        // Movable when the hole lies between its home slot and where it sits
+        if (((next - home) & SYMBOL_MASK) >= ((next - hole) & SYMBOL_MASK)) {
+            sync->symbols[hole] = sync->symbols[next];
+            sync->symbols[next] = NULL;
+            hole = next;
+        }
+        next = (next + 1) & SYMBOL_MASK;
+    }
+}
+
+// Upper case symbol of a diff depth stream: "@depth" or "@depth@<speed>", not the
+// partial "@depth<levels>"
+static bool depth_stream_symbol(const char *stream, char symbol[DEPTH_SYNC_SYMBOL_SIZE]) {
+    const char *at = strchr(stream, '@');
+    if (!at || strncmp(at + 1, "depth", 5) != 0 || (at[6] != '\0' && at[6] != '@')) {
+        return false;
+    }
+
+    size_t len = (size_t)(at - stream);
+    if (len == 0 || len >= DEPTH_SYNC_SYMBOL_SIZE) {
+        return false;
+    }
+    for (size_t j = 0; j < len; j++) {
+        symbol[j] = (char)toupper((unsigned char)stream[j]);
+    }
+    symbol[len] = '\0';
+    return true;
+}
+
+void depth_sync_track_streams(depth_sync_t *sync, const char **streams, int count) {
+    if (!sync) {
+        return;
+    }
+
+    char symbol[DEPTH_SYNC_SYMBOL_SIZE];
+    for (int i = 0; i < count; i++) {
+        if (depth_stream_symbol(streams[i], symbol)) {
+            depth_sync_track(sync, symbol);
+        }
+    }
+
+    // Collect first: removal shifts entries between slots
+    char removed[DEPTH_SYNC_MAX_SYMBOLS][DEPTH_SYNC_SYMBOL_SIZE];
+    int removed_count = 0;
+    for (int slot = 0; slot < DEPTH_SYNC_MAX_SYMBOLS; slot++) {
+        const depth_symbol_t *entry = sync->symbols[slot];
+        if (!entry) {
+            continue;
+        }
+        bool listed = false;
+        for (int i = 0; i < count && !listed; i++) {
+            listed = depth_stream_symbol(streams[i], symbol) && strcmp(symbol, entry->symbol) == 0;
+        }
+        if (!listed) {
+            memcpy(removed[removed_count++], entry->symbol, DEPTH_SYNC_SYMBOL_SIZE);
+        }
+    }
+    for (int i = 0; i < removed_count; i++) {
+        depth_sync_untrack(sync, removed[i]);
+    }
+}
+
+static void clear_ring(depth_symbol_t *entry) {
+    entry->head = 0;
+    entry->tail = 0;
+}
+
+static int copy_levels(double **prices, double **quantities, int *capacity,
+                       const double *src_prices, const double *src_quantities, int count) {
+    if (count > *capacity) {
+        double *p = (double *)realloc(*prices, sizeof(double) * count);
+        if (!p) {
+            return -1;
+        }
+        *prices = p;
+        double *q = (double *)realloc(*quantities, sizeof(double) * count);
+        if (!q) {
+            return -1;
+        }
+        *quantities = q;
+        *capacity = count;
+    }
+    if (count > 0) {
+        memcpy(*prices, src_prices, sizeof(double) * count);
+        memcpy(*quantities, src_quantities, sizeof(double) * count);
+    }
+    return 0;
+}
+
+static void buffer_diff(depth_symbol_t *entry, const market_data_t *data) {
+    if (!entry->ring) {
+        entry->ring = (depth_diff_t *)calloc(DEPTH_SYNC_RING, sizeof(depth_diff_t));
+        if (!entry->ring) {
+            return;
+        }
+    }
+
+    // Full: the oldest diff goes; the merge detects the hole and fetches again if needed
+    if (entry->tail - entry->head == DEPTH_SYNC_RING) {
+        entry->head++;
+        metrics_inc(METRIC_DIFFS_DROPPED);
+    }
+
+    depth_diff_t *diff = &entry->ring[entry->tail & RING_MASK];
+    if (copy_levels(&diff->bid_prices, &diff->bid_quantities, &diff->bid_capacity,
+                    data->bid_prices, data->bid_quantities, data->bid_count) < 0 ||
+        copy_levels(&diff->ask_prices, &diff->ask_quantities, &diff->ask_capacity,
+                    data->ask_prices, data->ask_quantities, data->ask_count) < 0) {
+        metrics_inc(METRIC_DIFFS_DROPPED);
+        return;
+    }
+    diff->first_update_id = data->first_update_id;
+    diff->final_update_id = data->final_update_id;
+    diff->prev_final_update_id = data->prev_final_update_id;
+    diff->bid_count = data->bid_count;
+    diff->ask_count = data->ask_count;
+    entry->tail++;
+}
+
+// Diff already contained in the book
+static bool is_stale(const depth_symbol_t *entry, long final_update_id) {
+    long last = entry->book.last_update_id;
+    return final_update_id < last || (entry->first_applied && final_update_id == last);
+}
+
+// Whether a diff continues the book: the first one must straddle the snapshot id,
+// later ones chain on pu (futures) or on U == last u + 1 (spot)
+static bool continues(const depth_symbol_t *entry, long first_update_id, long prev_final_update_id) {
+    long last = entry->book.last_update_id;
+    if (!entry->first_applied) {
+        return first_update_id <= last + 1;
+    }
+    if (prev_final_update_id != 0) {
+        return prev_final_update_id == last;
+    }
+    return first_update_id == last + 1;
+}
+
+static void apply_levels(depth_symbol_t *entry, const double *bid_prices, const double *bid_quantities,
+                         int bid_count, const double *ask_prices, const double *ask_quantities,
+                         int ask_count, long final_update_id) {
+    for (int i = 0; i < bid_count; i++) {
+        order_book_set(&entry->book, true, bid_prices[i], bid_quantities[i]);
+    }
+    for (int i = 0; i < ask_count; i++) {
+        order_book_set(&entry->book, false, ask_prices[i], ask_quantities[i]);
+    }
+    entry->book.last_update_id = final_update_id;
+    entry->first_applied = true;
+    entry->diffs_applied++;
+}
+
+static void report_synced(depth_sync_t *sync) {
+    metrics_gauge_set(METRIC_BOOKS_LIVE, sync->live_count);
+    if (sync->live_count < sync->symbol_count || !sync->sync_started_ns) {
+        return;
+    }
+
+    int64_t elapsed = metrics_clock_ns() - sync->sync_started_ns;
+    metrics_gauge_set(METRIC_BOOK_SYNC_NS, elapsed);
+    if (sync->on_log) {
+        char message[96];
+        snprintf(message, sizeof(message), "%d order books consistent after %.1f ms",
+                 sync->live_count, (double)elapsed / 1e6);
+        sync->on_log(sync->log_user, message);
+    }
+    sync->sync_started_ns = 0;
+}
+
+// First diff continued the snapshot: the book is consistent from here on
+static void go_live(depth_sync_t *sync, depth_symbol_t *entry) {
+    entry->state = BOOK_LIVE;
+    sync->live_count++;
+    report_synced(sync);
+}
+
+// Drop the book and wait for a new snapshot
+static void resync(depth_sync_t *sync, depth_symbol_t *entry, int64_t retry_at_ns) {
+    if (entry->state == BOOK_LIVE) {
+        sync->live_count--;
+        entry->resyncs++;
+        metrics_inc(METRIC_BOOK_RESYNCS);
+    }
+    entry->state = BOOK_WAIT_SNAPSHOT;
+    entry->retry_at_ns = retry_at_ns;
+    entry->first_applied = false;
+    order_book_clear(&entry->book);
+    mark_unsynced(sync);
+}
+
+void depth_sync_update(depth_sync_t *sync, const market_data_t *data) {
+    if (!sync || !data || data->event != MARKET_EVENT_DEPTH || !data->symbol) {
+        return;
+    }
+
+    depth_symbol_t *entry = find_symbol(sync, data->symbol);
+    if (!entry) {
+        return;
+    }
+
+    if (entry->state != BOOK_LIVE && entry->state != BOOK_SNAPSHOT) {
+        buffer_diff(entry, data);
+        return;
+    }
+
+    if (is_stale(entry, data->final_update_id)) {
+        return;
+    }
+
+    if (!continues(entry, data->first_update_id, data->prev_final_update_id)) {
+        fprintf(stderr, "Order book %s out of sync at U=%ld (book at %ld), fetching snapshot\n",
+                entry->symbol, data->first_update_id, entry->book.last_update_id);
+        resync(sync, entry, 0);
+        clear_ring(entry);
+        buffer_diff(entry, data);
+        return;
+    }
+
+    apply_levels(entry, data->bid_prices, data->bid_quantities, data->bid_count,
+                 data->ask_prices, data->ask_quantities, data->ask_count, data->final_update_id);
+    if (entry->state == BOOK_SNAPSHOT) {
+        go_live(sync, entry);
+    }
+}
+
+int depth_sync_resync(depth_sync_t *sync, const char *symbol) {
+    depth_symbol_t *entry = sync ? find_symbol(sync, symbol) : NULL;
+    if (!entry) {
+        return -1;
+    }
+
+    // A fetch in flight is kept: replay checks it against the diffs after the gap
+    if (entry->state == BOOK_LIVE || entry->state == BOOK_SNAPSHOT) {
+        resync(sync, entry, 0);
+    }
+    clear_ring(entry);
+    return 0;
+}
+
+static void on_snapshot(void *ctx, const char *symbol, int status, const char *body, size_t len) {
+    depth_sync_t *sync = (depth_sync_t *)ctx;
+    depth_symbol_t *entry = find_symbol(sync, symbol);
+    if (!entry || entry->state != BOOK_FETCHING) {
+        return;
+    }
+
+    int64_t now = metrics_clock_ns();
+    market_data_t *snapshot = (status == 200) ? parse_depth_snapshot(body, len) : NULL;
+    if (!snapshot) {
+        fprintf(stderr, "Depth snapshot for %s failed (HTTP %d), retrying\n", symbol, status);
+        entry->state = BOOK_WAIT_SNAPSHOT;
+        entry->retry_at_ns = now + DEPTH_SYNC_RETRY_NS;
+        return;
+    }
+
+    int loaded = order_book_load(&entry->book, snapshot->bid_prices, snapshot->bid_quantities,
+                                 snapshot->bid_count, snapshot->ask_prices,
+                                 snapshot->ask_quantities, snapshot->ask_count,
+                                 snapshot->final_update_id);
+    free_market_data(snapshot);
+    entry->first_applied = false;
+    if (loaded < 0) {
+        entry->state = BOOK_WAIT_SNAPSHOT;
+        entry->retry_at_ns = now + DEPTH_SYNC_RETRY_NS;
+        return;
+    }
+
+    // Replay buffered diffs in order on top of the snapshot
+    while (entry->head != entry->tail) {
+        const depth_diff_t *diff = &entry->ring[entry->head & RING_MASK];
+        if (is_stale(entry, diff->final_update_id)) {
+            entry->head++;
+            continue;
+        }
+        if (!continues(entry, diff->first_update_id, diff->prev_final_update_id)) {
+            // Snapshot older than the buffered diffs or a hole in the buffer:
+            // keep the rest and fetch a newer snapshot
+            entry->state = BOOK_WAIT_SNAPSHOT;
+            entry->retry_at_ns = now;
+            entry->first_applied = false;
+            order_book_clear(&entry->book);
+            return;
+        }
+        apply_levels(entry, diff->bid_prices, diff->bid_quantities, diff->bid_count,
+                     diff->ask_prices, diff->ask_quantities, diff->ask_count,
+                     diff->final_update_id);
+        entry->head++;
+    }
+
+    // Without a diff on top, nothing shows the snapshot is not already behind
+    // the stream; the first live diff has to straddle it
+    if (entry->first_applied) {
+        go_live(sync, entry);
+    } else {
+        entry->state = BOOK_SNAPSHOT;
+    }
+}
+
+void depth_sync_pump(depth_sync_t *sync) {
+    if (!sync || sync->live_count == sync->symbol_count) {
+        return;
+    }
+
+    int64_t now = metrics_clock_ns();
+    for (int i = 0; i < DEPTH_SYNC_MAX_SYMBOLS; i++) {
+        int slot = (sync->pump_cursor + i) & SYMBOL_MASK;
+        depth_symbol_t *entry = sync->symbols[slot];
+        if (!entry || entry->state != BOOK_WAIT_SNAPSHOT || entry->retry_at_ns > now) {
+            continue;
+        }
+        if (!snapshot_fetcher_ready(sync->fetcher, now)) {
+            // Resume from this symbol next time so every book gets its turn
+            sync->pump_cursor = slot;
+            return;
+        }
+
+        // Set before starting: a failure may be reported from inside the start call
+        entry->state = BOOK_FETCHING;
+        if (snapshot_fetcher_start(sync->fetcher, entry->symbol, now) < 0) {
+            entry->state = BOOK_WAIT_SNAPSHOT;
+            entry->retry_at_ns = now + DEPTH_SYNC_RETRY_NS;
+        }
+    }
+}
+
+const order_book_t* depth_sync_book(const depth_sync_t *sync, const char *symbol) {
+    if (!sync || !symbol) {
+        return NULL;
+    }
+    depth_symbol_t *entry = find_symbol(sync, symbol);
+    return (entry && entry->state == BOOK_LIVE) ? &entry->book : NULL;
+}
+
+int depth_sync_untrack(depth_sync_t *sync, const char *symbol) {
+    if (!sync || !symbol) {
+        return -1;
+    }
+
+    bool found;
+    int slot = lookup_symbol(sync, symbol, &found);
+    if (!found) {
+        return -1;
+    }
+
+    depth_symbol_t *entry = sync->symbols[slot];
+    if (entry->state == BOOK_FETCHING) {
+        snapshot_fetcher_cancel(sync->fetcher, entry->symbol);
+    }
+    if (entry->state == BOOK_LIVE) {
+        sync->live_count--;
+    }
+    sync->symbol_count--;
+    remove_slot(sync, (unsigned int)slot);
+    free_symbol(entry);
+
+    // The removed book may have been the last one out of sync
+    if (sync->symbol_count == 0) {
+        sync->sync_started_ns = 0;
+        metrics_gauge_set(METRIC_BOOKS_LIVE, 0);
+    } else {
+        report_synced(sync);
+    }
+    return 0;
+}
+
+void depth_sync_reset_all(depth_sync_t *sync) {
+    if (!sync) {
+        return;
+    }
+
+    for (int i = 0; i < DEPTH_SYNC_MAX_SYMBOLS; i++) {
+        depth_symbol_t *entry = sync->symbols[i];
+        if (!entry) {
+            continue;
+        }
+        // In-flight snapshots are still useful: the merge checks them against the new diffs
+        if (entry->state == BOOK_LIVE || entry->state == BOOK_SNAPSHOT) {
+            if (entry->state == BOOK_LIVE) {
+                sync->live_count--;
+            }
+            entry->state = BOOK_WAIT_SNAPSHOT;
+            entry->retry_at_ns = 0;
+        }
+        entry->first_applied = false;
+        order_book_clear(&entry->book);
+        clear_ring(entry);
+    }
+
+    if (sync->symbol_count > 0) {
+        mark_unsynced(sync);
+    }
+}
+
+static const char *state_names[] = { "waiting", "fetching", "snapshot", "live" };
+
+void depth_sync_print(const depth_sync_t *sync) {
+    if (!sync) {
+        return;
+    }
+
+    printf("\n=== Order Books ===\n");
+    for (int i = 0; i < DEPTH_SYNC_MAX_SYMBOLS; i++) {
+        const depth_symbol_t *entry = sync->symbols[i];
+        if (!entry) {
+            continue;
+        }
+        double bid = 0.0, ask = 0.0;
+        order_book_best_bid(&entry->book, &bid, NULL);
+        order_book_best_ask(&entry->book, &ask, NULL);
+        printf("%-12s %-8s levels=%d/%d bid=%.8f ask=%.8f u=%ld diffs=%llu resyncs=%llu\n",
+               entry->symbol, state_names[entry->state], entry->book.bids.count,
+               entry->book.asks.count, bid, ask, entry->book.last_update_id,
+               (unsigned long long)entry->diffs_applied, (unsigned long long)entry->resyncs);
+    }
+    printf("===================\n");
+}
+
+void depth_sync_destroy(depth_sync_t *sync) {
+    if (!sync) {
+        return;
+    }
+
+    for (int i = 0; i < DEPTH_SYNC_MAX_SYMBOLS; i++) {
+        depth_symbol_t *entry = sync->symbols[i];
+        if (!entry) {
+            continue;
+        }
+        free_symbol(entry);
+    }
+
+    snapshot_fetcher_destroy(sync->fetcher);
+    free(sync);
+}
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "event_merger.h"
+#include "metrics.h"
+#include "socket_tuning.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Held event, ordered by exchange time then arrival
+typedef struct {
+    market_data_t *data;
+    int64_t event_ms;      // "E", or "T" when the stream sends no event time
+    uint64_t seq;          // arrival order, breaks ties between equal times
+    int64_t arrival_ns;    // monotonic time the event was pushed
+} merge_entry_t;
+
+struct event_merger {
+    pthread_mutex_t lock;
+
+    // Binary min-heap of held events
+    merge_entry_t *heap;
+    size_t count;
+    size_t capacity;
+
+    int64_t window_ns;          // longest an event is held waiting for older ones
+    int64_t window_ms;
+    int64_t max_lateness_ms;    // how far behind the watermark an event may still be delivered
+
+    int64_t newest_ms;          // newest event time pushed
+    int64_t watermark_ms;       // event time of the last in-order release
+    uint64_t next_seq;
+
+    uint64_t pushed;
+    uint64_t released;
+    uint64_t untimed;           // events without exchange time, passed straight through
+    uint64_t late;
+    uint64_t late_dropped;
+    uint64_t future_dropped;    // stamped too far ahead of the local clock
+    uint64_t forced;
+    uint64_t hold_ns;           // total local time released events were held
+    int64_t max_hold_ns;
+
+    event_merger_fn on_event;
+    void *user;
+};
+
+event_merger_t* event_merger_create(int window_ms, int max_lateness_ms, size_t capacity,
+                                    event_merger_fn on_event, void *user) {
+    event_merger_t *merger = (event_merger_t *)calloc(1, sizeof(event_merger_t));
+    if (!merger) {
+        return NULL;
+    }
+
+    merger->capacity = capacity > 0 ? capacity : EVENT_MERGER_DEFAULT_CAPACITY;
+    merger->heap = (merge_entry_t *)malloc(sizeof(merge_entry_t) * merger->capacity);
+    if (!merger->heap) {
+        free(merger);
+        return NULL;
+    }
+
+    merger->window_ms = window_ms > 0 ? window_ms : 0;
+    merger->window_ns = merger->window_ms * 1000000LL;
+    merger->max_lateness_ms = max_lateness_ms > 0 ? max_lateness_ms : 0;
+    merger->on_event = on_event;
+    merger->user = user;
+    pthread_mutex_init(&merger->lock, NULL);
+    return merger;
+}
+
+static bool entry_before(const merge_entry_t *a, const merge_entry_t *b) {
+    return a->event_ms < b->event_ms || (a->event_ms == b->event_ms && a->seq < b->seq);
+}
+
+static void heap_insert(event_merger_t *merger, const merge_entry_t *entry) {
+    merge_entry_t *heap = merger->heap;
+    size_t i = merger->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!entry_before(entry, &heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = *entry;
+}
+
+static merge_entry_t heap_pop(event_merger_t *merger) {
+    merge_entry_t *heap = merger->heap;
+    merge_entry_t top = heap[0];
+    merge_entry_t last = heap[--merger->count];
+
+    // Sift the last entry down from the root
+    size_t i = 0;
+    size_t n = merger->count;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && entry_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!entry_before(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (n > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// Hand an event to the consumer, the merger owns and frees it
+static void deliver(event_merger_t *merger, market_data_t *data, bool late) {
+    if (merger->on_event) {
+        merger->on_event(merger->user, data, late);
+    }
+    free_market_data(data);
+}
+
+static void release_head(event_merger_t *merger, int64_t now_ns) {
+    merge_entry_t entry = heap_pop(merger);
+
+    // Late events keep their place behind the watermark, which never moves back
+    bool late = entry.event_ms < merger->watermark_ms;
+    if (late) {
+        merger->late++;
+        metrics_inc(METRIC_LATE_EVENTS);
+    } else {
+        merger->watermark_ms = entry.event_ms;
+    }
+
+    int64_t hold = now_ns - entry.arrival_ns;
+    if (hold < 0) {
+        hold = 0;
+    }
+    if (hold > merger->max_hold_ns) {
+        merger->max_hold_ns = hold;
+    }
+    merger->hold_ns += (uint64_t)hold;
+    merger->released++;
+    metrics_inc(METRIC_EVENTS_MERGED);
+    metrics_add(METRIC_MERGE_HOLD_NANOSECONDS, (uint64_t)hold);
+
+    deliver(merger, entry.data, late);
+}
+
+// The oldest event can go once newer event time covers the window, once it has
+// waited the window in local time, or when it is already behind the watermark
+static bool head_ready(const event_merger_t *merger, int64_t now_ns) {
+    const merge_entry_t *head = &merger->heap[0];
+    return head->event_ms <= merger->newest_ms - merger->window_ms ||
+           now_ns - head->arrival_ns >= merger->window_ns ||
+           head->event_ms < merger->watermark_ms;
+}
+
+static void release_ready(event_merger_t *merger, int64_t now_ns) {
+    while (merger->count > 0 && head_ready(merger, now_ns)) {
+        release_head(merger, now_ns);
+    }
+    metrics_gauge_set(METRIC_MERGE_PENDING, (int64_t)merger->count);
+}
+
+void event_merger_push(event_merger_t *merger, market_data_t *data, int64_t now_ns) {
+    if (!data) {
+        return;
+    }
+    if (!merger) {
+        free_market_data(data);
+        return;
+    }
+
+    int64_t event_ms = data->event_time ? data->event_time : data->timestamp;
+
+    pthread_mutex_lock(&merger->lock);
+    merger->pushed++;
+
+    // Responses and events without exchange time cannot be ordered
+    if (event_ms <= 0) {
+        merger->untimed++;
+        deliver(merger, data, false);
+        pthread_mutex_unlock(&merger->lock);
+        return;
+    }
+
+    // A clock running ahead would drag the watermark along and every event after
+    // it would count as late, so such stamps are refused instead of ordered
+    int64_t local_ms = (data->receive_time_ns ? data->receive_time_ns : socket_tuning_now_ns()) /
+                       1000000;
+    if (event_ms > local_ms + EVENT_MERGER_MAX_AHEAD_MS) {
+        merger->future_dropped++;
+        metrics_inc(METRIC_FUTURE_DROPS);
+        pthread_mutex_unlock(&merger->lock);
+        free_market_data(data);
+        return;
+    }
+
+    if (event_ms < merger->watermark_ms - merger->max_lateness_ms) {
+        merger->late_dropped++;
+        metrics_inc(METRIC_LATE_DROPS);
+        pthread_mutex_unlock(&merger->lock);
+        free_market_data(data);
+        return;
+    }
+
+    // Window full: give up on the oldest event waiting for stragglers
+    if (merger->count == merger->capacity) {
+        merger->forced++;
+        metrics_inc(METRIC_MERGE_FORCED);
+        release_head(merger, now_ns);
+    }
+
+    merge_entry_t entry;
+    entry.data = data;
+    entry.event_ms = event_ms;
+    entry.seq = merger->next_seq++;
+    entry.arrival_ns = now_ns;
+    heap_insert(merger, &entry);
+    if (event_ms > merger->newest_ms) {
+        merger->newest_ms = event_ms;
+    }
+
+    release_ready(merger, now_ns);
+    pthread_mutex_unlock(&merger->lock);
+}
+
+void event_merger_drain(event_merger_t *merger, int64_t now_ns) {
+    if (!merger) {
+        return;
+    }
+
+    pthread_mutex_lock(&merger->lock);
+    release_ready(merger, now_ns);
+    pthread_mutex_unlock(&merger->lock);
+}
+
+void event_merger_flush(event_merger_t *merger) {
+    if (!merger) {
+        return;
+    }
+
+    pthread_mutex_lock(&merger->lock);
+    int64_t now = metrics_clock_ns();
+    while (merger->count > 0) {
+        release_head(merger, now);
+    }
+    metrics_gauge_set(METRIC_MERGE_PENDING, 0);
+    pthread_mutex_unlock(&merger->lock);
+}
+
+void event_merger_print(event_merger_t *merger) {
+    if (!merger) {
+        return;
+    }
+
+    pthread_mutex_lock(&merger->lock);
+    printf("\n=== Event Merge ===\n");
+    printf("window=%lldms lateness=%lldms pushed=%llu released=%llu untimed=%llu held=%zu\n",
+           (long long)merger->window_ms, (long long)merger->max_lateness_ms,
+           (unsigned long long)merger->pushed, (unsigned long long)merger->released,
+           (unsigned long long)merger->untimed, merger->count);
+    printf("late=%llu late_dropped=%llu future_dropped=%llu forced=%llu hold_avg=%.3fms "
+           "hold_max=%.3fms\n",
+           (unsigned long long)merger->late, (unsigned long long)merger->late_dropped,
+           (unsigned long long)merger->future_dropped, (unsigned long long)merger->forced,
+           merger->released ? (double)merger->hold_ns / (double)merger->released / 1e6 : 0.0,
+           (double)merger->max_hold_ns / 1e6);
+    printf("===================\n");
+    pthread_mutex_unlock(&merger->lock);
+}
+
+void event_merger_destroy(event_merger_t *merger) {
+    if (!merger) {
+        return;
+    }
+
+    for (size_t i = 0; i < merger->count; i++) {
+        free_market_data(merger->heap[i].data);
+    }
+    free(merger->heap);
+    pthread_mutex_destroy(&merger->lock);
+    free(merger);
+}
\ No newline at end of file
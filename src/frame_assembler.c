@@ -0,0 +1,84 @@
+#include "frame_assembler.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void frame_assembler_init(frame_assembler_t *assembler, size_t max_size) {
+    memset(assembler, 0, sizeof(*assembler));
+    assembler->max_size = max_size;
+}
+
+static bool reserve(frame_assembler_t *assembler, size_t needed) {
+    if (needed <= assembler->capacity) {
+        return true;
+    }
+
+    size_t capacity = assembler->capacity ? assembler->capacity : 4096;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    char *buffer = (char *)realloc(assembler->buffer, capacity);
+    metrics_inc(METRIC_ALLOCATIONS);
+    if (!buffer) {
+        return false;
+    }
+    assembler->buffer = buffer;
+    assembler->capacity = capacity;
+    return true;
+}
+
+frame_status_t frame_assembler_push(frame_assembler_t *assembler, const void *data, size_t len,
+                                    bool first, bool final) {
+    // A first fragment always starts a new message, even if the last one never finished
+    if (first || !assembler->in_message) {
+        assembler->len = 0;
+        assembler->dropping = false;
+        assembler->in_message = true;
+    }
+
+    if (!assembler->dropping) {
+        // Room for the terminating NUL, checked without overflowing size_t
+        if (len > assembler->max_size || assembler->len > assembler->max_size - len ||
+            !reserve(assembler, assembler->len + len + 1)) {
+            fprintf(stderr, "Warning: Dropping message larger than %zu bytes\n",
+                    assembler->max_size);
+            assembler->dropping = true;
+            assembler->dropped++;
+        } else if (len > 0) {
+            memcpy(assembler->buffer + assembler->len, data, len);
+            assembler->len += len;
+        }
+    }
+
+    if (!final) {
+        return FRAME_PARTIAL;
+    }
+
+    assembler->in_message = false;
+    if (assembler->dropping) {
+        assembler->len = 0;
+        return FRAME_DROPPED;
+    }
+    if (!reserve(assembler, assembler->len + 1)) {
+        assembler->len = 0;
+        assembler->dropped++;
+        return FRAME_DROPPED;
+    }
+    assembler->buffer[assembler->len] = '\0';
+    return FRAME_COMPLETE;
+}
+
+void frame_assembler_reset(frame_assembler_t *assembler) {
+    assembler->len = 0;
+    assembler->in_message = false;
+    assembler->dropping = false;
+}
+
+void frame_assembler_free(frame_assembler_t *assembler) {
+    free(assembler->buffer);
+    assembler->buffer = NULL;
+    assembler->len = 0;
+    assembler->capacity = 0;
+}
\ No newline at end of file
@@ -1,167 +1,453 @@
 #include "json_parser.h"
+#include "metrics.h"
 #include <json-c/json.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-market_data_t* parse_market_data(const char *json_str, size_t len) {
+// Field tables: first key char, second key char ('\0' for one char keys),
+// market_data_t field, storage kind. Keys without an entry are skipped.
+#define AGG_TRADE_FIELDS(X) \
+    X('s', '\0', symbol,         SYMBOL) \
+    X('E', '\0', event_time,     INT64)  \
+    X('p', '\0', price,          DOUBLE) \
+    X('q', '\0', quantity,       DOUBLE) \
+    X('T', '\0', timestamp,      INT64)  \
+    X('a', '\0', agg_trade_id,   INT64)  \
+    X('f', '\0', first_trade_id, INT64)  \
+    X('l', '\0', last_trade_id,  INT64)  \
+    X('m', '\0', is_buyer_maker, BOOL)
+
+#define MARK_PRICE_FIELDS(X) \
+    X('s', '\0', symbol,     SYMBOL) \
+    X('E', '\0', event_time, INT64)  \
+    X('p', '\0', price,      DOUBLE) \
+    X('T', '\0', timestamp,  INT64)
+
+#define KLINE_FIELDS(X) \
+    X('s', '\0', symbol,     SYMBOL) \
+    X('E', '\0', event_time, INT64)  \
+    X('k', '\0', open_time,  KLINE)
+
+// Nested "k" object of kline events
+#define KLINE_BODY_FIELDS(X) \
+    X('t', '\0', open_time,  INT64)  \
+    X('o', '\0', open,       DOUBLE) \
+    X('h', '\0', high,       DOUBLE) \
+    X('l', '\0', low,        DOUBLE) \
+    X('c', '\0', close,      DOUBLE) \
+    X('v', '\0', volume,     DOUBLE) \
+    X('T', '\0', close_time, INT64)
+
+#define TICKER_FIELDS(X) \
+    X('s', '\0', symbol,     SYMBOL) \
+    X('E', '\0', event_time, INT64)  \
+    X('c', '\0', price,      DOUBLE) \
+    X('v', '\0', volume,     DOUBLE)
+
+#define BOOK_TICKER_FIELDS(X) \
+    X('s', '\0', symbol,          SYMBOL)    \
+    X('E', '\0', event_time,      INT64)     \
+    X('u', '\0', final_update_id, INT64)     \
+    X('T', '\0', timestamp,       INT64)     \
+    X('b', '\0', bid_prices,      BEST_BID)  \
+    X('B', '\0', bid_quantities,  BEST_QTY)  \
+    X('a', '\0', ask_prices,      BEST_ASK)  \
+    X('A', '\0', ask_quantities,  BEST_QTY)
+
+#define DEPTH_FIELDS(X) \
+    X('s', '\0', symbol,               SYMBOL)     \
+    X('E', '\0', event_time,           INT64)      \
+    X('T', '\0', timestamp,            INT64)      \
+    X('U', '\0', first_update_id,      INT64)      \
+    X('u', '\0', final_update_id,      INT64)      \
+    X('p', 'u',  prev_final_update_id, INT64)      \
+    X('b', '\0', bid_prices,           BID_LEVELS) \
+    X('a', '\0', ask_prices,           ASK_LEVELS)
+
+static void store_symbol(char **slot, struct json_object *val);
+static void store_best(double **slot, struct json_object *val);
+static void store_levels(struct json_object *arr, double **prices, double **quantities, int *count);
+static void fill_KLINE_BODY(struct json_object *obj, market_data_t *data);
+
+// How each storage kind writes a value into market_data_t
+#define STORE_SYMBOL(data, field, val) store_symbol(&(data)->field, val);
+#define STORE_DOUBLE(data, field, val) (data)->field = json_object_get_double(val);
+#define STORE_INT64(data, field, val) (data)->field = json_object_get_int64(val);
+#define STORE_BOOL(data, field, val) (data)->field = json_object_get_boolean(val);
+#define STORE_KLINE(data, field, val) \
+    if (json_object_is_type(val, json_type_object)) { fill_KLINE_BODY(val, data); }
+#define STORE_BEST_BID(data, field, val) store_best(&(data)->field, val); (data)->bid_count = 1;
+#define STORE_BEST_ASK(data, field, val) store_best(&(data)->field, val); (data)->ask_count = 1;
+#define STORE_BEST_QTY(data, field, val) store_best(&(data)->field, val);
+#define STORE_BID_LEVELS(data, field, val) \
+    store_levels(val, &(data)->bid_prices, &(data)->bid_quantities, &(data)->bid_count);
+#define STORE_ASK_LEVELS(data, field, val) \
+    store_levels(val, &(data)->ask_prices, &(data)->ask_quantities, &(data)->ask_count);
+
+#define FIELD_CASE(c0, c1, field, kind)                              \
+    case c0:                                                         \
+        if (key[1] == (c1) && ((c1) == '\0' || key[2] == '\0')) {    \
+            STORE_##kind(data, field, val)                           \
+        }                                                            \
+        break;
+
+// One filler per table: a single pass over the object keys, switching on the first key char
+#define DEFINE_FILLER(name, fields)                                         \
+    static void fill_##name(struct json_object *obj, market_data_t *data) { \
+        json_object_object_foreach(obj, key, val) {                         \
+            switch (key[0]) {                                               \
+                fields(FIELD_CASE)                                          \
+                default:                                                    \
+                    break;                                                  \
+            }                                                               \
+        }                                                                   \
+    }
+
+DEFINE_FILLER(AGG_TRADE, AGG_TRADE_FIELDS)
+DEFINE_FILLER(MARK_PRICE, MARK_PRICE_FIELDS)
+DEFINE_FILLER(KLINE, KLINE_FIELDS)
+DEFINE_FILLER(KLINE_BODY, KLINE_BODY_FIELDS)
+DEFINE_FILLER(TICKER, TICKER_FIELDS)
+DEFINE_FILLER(BOOK_TICKER, BOOK_TICKER_FIELDS)
+DEFINE_FILLER(DEPTH, DEPTH_FIELDS)
+
+typedef void (*market_filler_fn)(struct json_object *obj, market_data_t *data);
+
+static const char *event_names[MARKET_EVENT_COUNT] = {
+    NULL,
+#define X(id, name, stream) name,
+    MARKET_EVENT_TYPES(X)
+#undef X
+};
+
+static const char *event_streams[MARKET_EVENT_COUNT] = {
+    NULL,
+#define X(id, name, stream) stream,
+    MARKET_EVENT_TYPES(X)
+#undef X
+};
+
+static const market_filler_fn event_fillers[MARKET_EVENT_COUNT] = {
+    NULL,
+#define X(id, name, stream) fill_##id,
+    MARKET_EVENT_TYPES(X)
+#undef X
+};
+
+static void store_symbol(char **slot, struct json_object *val) {
+    // First occurrence wins, null and non-string values are ignored
+    if (*slot || !json_object_is_type(val, json_type_string)) {
+        return;
+    }
+    *slot = strdup(json_object_get_string(val));
+    metrics_inc(METRIC_ALLOCATIONS);
+}
+
+static void store_best(double **slot, struct json_object *val) {
+    if (!*slot) {
+        *slot = (double *)malloc(sizeof(double));
+        metrics_inc(METRIC_ALLOCATIONS);
+        if (!*slot) {
+            return;
+        }
+    }
+    (*slot)[0] = json_object_get_double(val);
+}
+
+static void store_levels(struct json_object *arr, double **prices, double **quantities, int *count) {
+    if (!json_object_is_type(arr, json_type_array)) {
+        return;
+    }
+
+    size_t len = json_object_array_length(arr);
+    free(*prices);
+    free(*quantities);
+    *prices = NULL;
+    *quantities = NULL;
+    *count = 0;
+    if (len == 0 || len > INT_MAX) {
+        return;
+    }
+
+    *prices = (double *)malloc(sizeof(double) * len);
+    *quantities = (double *)malloc(sizeof(double) * len);
+    metrics_add(METRIC_ALLOCATIONS, 2);
+    if (!*prices || !*quantities) {
+        free(*prices);
+        free(*quantities);
+        *prices = NULL;
+        *quantities = NULL;
+        return;
+    }
+
+    // Each level is [price, quantity], malformed levels are skipped
+    int n = 0;
+    for (size_t i = 0; i < len; i++) {
+        struct json_object *level = json_object_array_get_idx(arr, i);
+        if (!json_object_is_type(level, json_type_array) || json_object_array_length(level) < 2) {
+            continue;
+        }
+        (*prices)[n] = json_object_get_double(json_object_array_get_idx(level, 0));
+        (*quantities)[n] = json_object_get_double(json_object_array_get_idx(level, 1));
+        n++;
+    }
+    *count = n;
+}
+
+static market_event_t event_from_name(const char *name) {
+    if (!name) {
+        return MARKET_EVENT_NONE;
+    }
+#define X(id, ename, stream) if (strcmp(name, ename) == 0) { return MARKET_EVENT_##id; }
+    MARKET_EVENT_TYPES(X)
+#undef X
+    return MARKET_EVENT_NONE;
+}
+
+// Tokener reused across messages of the same thread
+static _Thread_local struct json_tokener *thread_tokener = NULL;
+
+static struct json_object* parse_root(const char *json_str, size_t len) {
+    if (!json_str || len > INT_MAX) {
+        return NULL;
+    }
+
+    if (!thread_tokener) {
+        thread_tokener = json_tokener_new();
+        if (!thread_tokener) {
+            return NULL;
+        }
+    }
+
+    json_tokener_reset(thread_tokener);
+    struct json_object *root = json_tokener_parse_ex(thread_tokener, json_str, (int)len);
+    if (root && !json_object_is_type(root, json_type_object)) {
+        json_object_put(root);
+        return NULL;
+    }
+    return root;
+}
+
+// Messages without an event type: errors and subscription responses. Both reach
+// embedders through on_message, errors are not events.
+static market_data_t* parse_response(struct json_object *root, market_data_t *data) {
+    if (json_object_object_get_ex(root, "error", NULL)) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+// Drop book sides whose price or quantity column is missing, so consumers
+// can trust bid_count/ask_count alone
+static void check_sides(market_data_t *data) {
+    if (!data->bid_prices || !data->bid_quantities) {
+        data->bid_count = 0;
+    }
+    if (!data->ask_prices || !data->ask_quantities) {
+        data->ask_count = 0;
+    }
+}
+
+// Shared body of all parsers. With a constant expected event and filler this
+// inlines into a parser that checks one event name and calls one filler.
+static inline market_data_t* parse_event(const char *json_str, size_t len,
+                                         market_event_t expected, market_filler_fn filler) {
     market_data_t *data = (market_data_t *)calloc(1, sizeof(market_data_t));
+    metrics_inc(METRIC_ALLOCATIONS);
     if (!data) {
         return NULL;
     }
-    
-    struct json_object *root = json_tokener_parse(json_str);
+
+    struct json_object *root = parse_root(json_str, len);
     if (!root) {
         free(data);
         return NULL;
     }
-    
+
     struct json_object *obj;
-    
-    // Check if it's an error response
-    if (json_object_object_get_ex(root, "error", &obj)) {
-        printf("Error in response: %s\n", json_object_get_string(obj));
+    if (!json_object_object_get_ex(root, "e", &obj)) {
+        data = parse_response(root, data);
         json_object_put(root);
-        free(data);
+        return data;
+    }
+
+    const char *name = json_object_get_string(obj);
+    if (filler && name && strcmp(name, event_names[expected]) == 0) {
+        data->event = expected;
+        data->event_type = event_names[expected];
+        filler(root, data);
+    } else {
+        // Generic path, also taken when a specialized parser sees another event
+        market_event_t event = event_from_name(name);
+        if (event != MARKET_EVENT_NONE) {
+            data->event = event;
+            data->event_type = event_names[event];
+            event_fillers[event](root, data);
+        }
+    }
+    check_sides(data);
+
+    json_object_put(root);
+    return data;
+}
+
+market_data_t* parse_market_data(const char *json_str, size_t len) {
+    return parse_event(json_str, len, MARKET_EVENT_NONE, NULL);
+}
+
+market_data_t* parse_depth_snapshot(const char *json_str, size_t len) {
+    struct json_object *root = parse_root(json_str, len);
+    if (!root) {
         return NULL;
     }
-    
-    // Check if it's a subscription response
-    if (json_object_object_get_ex(root, "result", &obj)) {
-        printf("Subscription response received\n");
+
+    struct json_object *obj;
+    if (!json_object_object_get_ex(root, "lastUpdateId", &obj)) {
         json_object_put(root);
-        return data;
+        return NULL;
     }
-    
-    // Parse event type
-    if (json_object_object_get_ex(root, "e", &obj)) {
-        data->event_type = strdup(json_object_get_string(obj));
-    }
-    
-    // Parse symbol
-    if (json_object_object_get_ex(root, "s", &obj)) {
-        data->symbol = strdup(json_object_get_string(obj));
-    }
-    
-    // Parse based on event type
-    if (data->event_type) {
-        if (strcmp(data->event_type, "aggTrade") == 0) {
-            // Aggregate trade
-            if (json_object_object_get_ex(root, "p", &obj)) {
-                data->price = json_object_get_double(obj);
-            }
-            if (json_object_object_get_ex(root, "q", &obj)) {
-                data->quantity = json_object_get_double(obj);
-            }
-            if (json_object_object_get_ex(root, "T", &obj)) {
-                data->timestamp = json_object_get_int64(obj);
-            }
-        } else if (strcmp(data->event_type, "markPriceUpdate") == 0) {
-            // Mark price
-            if (json_object_object_get_ex(root, "p", &obj)) {
-                data->price = json_object_get_double(obj);
-            }
-            if (json_object_object_get_ex(root, "T", &obj)) {
-                data->timestamp = json_object_get_int64(obj);
-            }
-        } else if (strcmp(data->event_type, "kline") == 0) {
-            // Kline data
-            if (json_object_object_get_ex(root, "k", &obj)) {
-                struct json_object *kline_obj;
-                if (json_object_object_get_ex(obj, "t", &kline_obj)) {
-                    data->open_time = json_object_get_int64(kline_obj);
-                }
-                if (json_object_object_get_ex(obj, "o", &kline_obj)) {
-                    data->open = atof(json_object_get_string(kline_obj));
-                }
-                if (json_object_object_get_ex(obj, "h", &kline_obj)) {
-                    data->high = atof(json_object_get_string(kline_obj));
-                }
-                if (json_object_object_get_ex(obj, "l", &kline_obj)) {
-                    data->low = atof(json_object_get_string(kline_obj));
-                }
-                if (json_object_object_get_ex(obj, "c", &kline_obj)) {
-                    data->close = atof(json_object_get_string(kline_obj));
-                }
-                if (json_object_object_get_ex(obj, "v", &kline_obj)) {
-                    data->volume = atof(json_object_get_string(kline_obj));
-                }
-                if (json_object_object_get_ex(obj, "T", &kline_obj)) {
-                    data->close_time = json_object_get_int64(kline_obj);
-                }
-            }
-        } else if (strcmp(data->event_type, "24hrTicker") == 0) {
-            // 24hr ticker
-            if (json_object_object_get_ex(root, "c", &obj)) {
-                data->price = atof(json_object_get_string(obj));
-            }
-            if (json_object_object_get_ex(root, "v", &obj)) {
-                data->volume = atof(json_object_get_string(obj));
-            }
-        } else if (strcmp(data->event_type, "bookTicker") == 0) {
-            // Book ticker
-            if (json_object_object_get_ex(root, "b", &obj)) {
-                data->bid_prices = (double *)malloc(sizeof(double));
-                data->bid_prices[0] = atof(json_object_get_string(obj));
-                data->bid_count = 1;
-            }
-            if (json_object_object_get_ex(root, "B", &obj)) {
-                data->bid_quantities = (double *)malloc(sizeof(double));
-                data->bid_quantities[0] = atof(json_object_get_string(obj));
-            }
-            if (json_object_object_get_ex(root, "a", &obj)) {
-                data->ask_prices = (double *)malloc(sizeof(double));
-                data->ask_prices[0] = atof(json_object_get_string(obj));
-                data->ask_count = 1;
-            }
-            if (json_object_object_get_ex(root, "A", &obj)) {
-                data->ask_quantities = (double *)malloc(sizeof(double));
-                data->ask_quantities[0] = atof(json_object_get_string(obj));
-            }
-        } else if (strcmp(data->event_type, "depthUpdate") == 0) {
-            // Depth update
-            if (json_object_object_get_ex(root, "b", &obj)) {
-                int bid_array_len = json_object_array_length(obj);
-                data->bid_count = bid_array_len;
-                data->bid_prices = (double *)malloc(sizeof(double) * bid_array_len);
-                data->bid_quantities = (double *)malloc(sizeof(double) * bid_array_len);
-                
-                for (int i = 0; i < bid_array_len; i++) {
-                    struct json_object *bid = json_object_array_get_idx(obj, i);
-                    struct json_object *price_obj = json_object_array_get_idx(bid, 0);
-                    struct json_object *qty_obj = json_object_array_get_idx(bid, 1);
-                    data->bid_prices[i] = atof(json_object_get_string(price_obj));
-                    data->bid_quantities[i] = atof(json_object_get_string(qty_obj));
-                }
-            }
-            
-            if (json_object_object_get_ex(root, "a", &obj)) {
-                int ask_array_len = json_object_array_length(obj);
-                data->ask_count = ask_array_len;
-                data->ask_prices = (double *)malloc(sizeof(double) * ask_array_len);
-                data->ask_quantities = (double *)malloc(sizeof(double) * ask_array_len);
-                
-                for (int i = 0; i < ask_array_len; i++) {
-                    struct json_object *ask = json_object_array_get_idx(obj, i);
-                    struct json_object *price_obj = json_object_array_get_idx(ask, 0);
-                    struct json_object *qty_obj = json_object_array_get_idx(ask, 1);
-                    data->ask_prices[i] = atof(json_object_get_string(price_obj));
-                    data->ask_quantities[i] = atof(json_object_get_string(qty_obj));
-                }
-            }
-        }
+
+    market_data_t *data = (market_data_t *)calloc(1, sizeof(market_data_t));
+    if (!data) {
+        json_object_put(root);
+        return NULL;
     }
-    
+
+    data->final_update_id = json_object_get_int64(obj);
+    if (json_object_object_get_ex(root, "E", &obj)) {
+        data->event_time = json_object_get_int64(obj);
+    }
+    if (json_object_object_get_ex(root, "T", &obj)) {
+        data->timestamp = json_object_get_int64(obj);
+    }
+    if (json_object_object_get_ex(root, "bids", &obj)) {
+        store_levels(obj, &data->bid_prices, &data->bid_quantities, &data->bid_count);
+    }
+    if (json_object_object_get_ex(root, "asks", &obj)) {
+        store_levels(obj, &data->ask_prices, &data->ask_quantities, &data->ask_count);
+    }
+    check_sides(data);
+
     json_object_put(root);
     return data;
 }
 
+#define X(id, name, stream)                                                  \
+    static market_data_t* parse_##id(const char *json_str, size_t len) {     \
+        return parse_event(json_str, len, MARKET_EVENT_##id, fill_##id);     \
+    }
+MARKET_EVENT_TYPES(X)
+#undef X
+
+static const market_parser_fn event_parsers[MARKET_EVENT_COUNT] = {
+    parse_market_data,
+#define X(id, name, stream) parse_##id,
+    MARKET_EVENT_TYPES(X)
+#undef X
+};
+
+const char* market_event_name(market_event_t event) {
+    if (event <= MARKET_EVENT_NONE || event >= MARKET_EVENT_COUNT) {
+        return "none";
+    }
+    return event_names[event];
+}
+
+market_event_t market_event_from_stream(const char *stream) {
+    const char *at = stream ? strchr(stream, '@') : NULL;
+    if (!at) {
+        return MARKET_EVENT_NONE;
+    }
+    at++;
+
+    for (int event = 1; event < MARKET_EVENT_COUNT; event++) {
+        if (strncmp(at, event_streams[event], strlen(event_streams[event])) == 0) {
+            return (market_event_t)event;
+        }
+    }
+    return MARKET_EVENT_NONE;
+}
+
+market_parser_fn market_parser_for(market_event_t event) {
+    if (event <= MARKET_EVENT_NONE || event >= MARKET_EVENT_COUNT) {
+        return parse_market_data;
+    }
+    return event_parsers[event];
+}
+
+market_parser_fn market_parser_for_streams(const char **streams, int count) {
+    if (!streams || count <= 0) {
+        return parse_market_data;
+    }
+
+    market_event_t event = market_event_from_stream(streams[0]);
+    for (int i = 1; i < count; i++) {
+        if (market_event_from_stream(streams[i]) != event) {
+            return parse_market_data;
+        }
+    }
+    return market_parser_for(event);
+}
+
+// Scalar fields compared by market_data_compare
+#define COMPARED_DOUBLES(X) X(price) X(quantity) X(open) X(high) X(low) X(close) X(volume)
+#define COMPARED_INTEGERS(X) \
+    X(event) X(event_time) X(timestamp) X(is_buyer_maker) X(bid_count) X(ask_count) \
+    X(open_time) X(close_time) X(agg_trade_id) X(first_trade_id) X(last_trade_id) \
+    X(first_update_id) X(final_update_id) X(prev_final_update_id)
+
+static bool same_double(double a, double b) {
+    return a == b || (a != a && b != b);
+}
+
+static bool same_column(const double *a, const double *b, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!same_double(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* market_data_compare(const market_data_t *a, const market_data_t *b) {
+    if (!a || !b) {
+        return (a == b) ? NULL : "presence";
+    }
+
+#define X(field) if (a->field != b->field) { return #field; }
+    COMPARED_INTEGERS(X)
+#undef X
+#define X(field) if (!same_double(a->field, b->field)) { return #field; }
+    COMPARED_DOUBLES(X)
+#undef X
+
+    if ((a->symbol == NULL) != (b->symbol == NULL) ||
+        (a->symbol && strcmp(a->symbol, b->symbol) != 0)) {
+        return "symbol";
+    }
+    if (!same_column(a->bid_prices, b->bid_prices, a->bid_count)) {
+        return "bid_prices";
+    }
+    if (!same_column(a->bid_quantities, b->bid_quantities, a->bid_count)) {
+        return "bid_quantities";
+    }
+    if (!same_column(a->ask_prices, b->ask_prices, a->ask_count)) {
+        return "ask_prices";
+    }
+    if (!same_column(a->ask_quantities, b->ask_quantities, a->ask_count)) {
+        return "ask_quantities";
+    }
+    return NULL;
+}
+
 void free_market_data(market_data_t *data) {
     if (!data) {
         return;
     }
-    
-    free(data->event_type);
+
     free(data->symbol);
     free(data->bid_prices);
     free(data->bid_quantities);
@@ -170,53 +456,77 @@ void free_market_data(market_data_t *data) {
     free(data);
 }
 
+void free_parser_thread_state(void) {
+    if (thread_tokener) {
+        json_tokener_free(thread_tokener);
+        thread_tokener = NULL;
+    }
+}
+
 void print_market_data(const market_data_t *data) {
     if (!data || !data->event_type) {
         return;
     }
-    
+
     printf("\n=== Market Data ===\n");
     printf("Event: %s\n", data->event_type);
-    
+
     if (data->symbol) {
         printf("Symbol: %s\n", data->symbol);
     }
-    
-    if (strcmp(data->event_type, "aggTrade") == 0) {
-        printf("Price: %.8f\n", data->price);
-        printf("Quantity: %.8f\n", data->quantity);
-        printf("Timestamp: %ld\n", data->timestamp);
-    } else if (strcmp(data->event_type, "markPriceUpdate") == 0) {
-        printf("Mark Price: %.8f\n", data->price);
-        printf("Timestamp: %ld\n", data->timestamp);
-    } else if (strcmp(data->event_type, "kline") == 0) {
-        printf("Open: %.8f\n", data->open);
-        printf("High: %.8f\n", data->high);
-        printf("Low: %.8f\n", data->low);
-        printf("Close: %.8f\n", data->close);
-        printf("Volume: %.8f\n", data->volume);
-        printf("Open Time: %ld\n", data->open_time);
-        printf("Close Time: %ld\n", data->close_time);
-    } else if (strcmp(data->event_type, "24hrTicker") == 0) {
-        printf("Last Price: %.8f\n", data->price);
-        printf("Volume: %.8f\n", data->volume);
-    } else if (strcmp(data->event_type, "bookTicker") == 0) {
-        if (data->bid_count > 0) {
-            printf("Best Bid: %.8f @ %.8f\n", data->bid_prices[0], data->bid_quantities[0]);
-        }
-        if (data->ask_count > 0) {
-            printf("Best Ask: %.8f @ %.8f\n", data->ask_prices[0], data->ask_quantities[0]);
-        }
-    } else if (strcmp(data->event_type, "depthUpdate") == 0) {
-        printf("Bids (%d):\n", data->bid_count);
-        for (int i = 0; i < data->bid_count && i < 5; i++) {
-            printf("  %.8f @ %.8f\n", data->bid_prices[i], data->bid_quantities[i]);
-        }
-        printf("Asks (%d):\n", data->ask_count);
-        for (int i = 0; i < data->ask_count && i < 5; i++) {
-            printf("  %.8f @ %.8f\n", data->ask_prices[i], data->ask_quantities[i]);
-        }
+
+    switch (data->event) {
+        case MARKET_EVENT_AGG_TRADE:
+            printf("Price: %.8f\n", data->price);
+            printf("Quantity: %.8f\n", data->quantity);
+            printf("Timestamp: %ld\n", data->timestamp);
+            printf("Agg Trade ID: %ld (trades %ld-%ld)\n", data->agg_trade_id,
+                   data->first_trade_id, data->last_trade_id);
+            break;
+        case MARKET_EVENT_MARK_PRICE:
+            printf("Mark Price: %.8f\n", data->price);
+            printf("Timestamp: %ld\n", data->timestamp);
+            break;
+        case MARKET_EVENT_KLINE:
+            printf("Open: %.8f\n", data->open);
+            printf("High: %.8f\n", data->high);
+            printf("Low: %.8f\n", data->low);
+            printf("Close: %.8f\n", data->close);
+            printf("Volume: %.8f\n", data->volume);
+            printf("Open Time: %ld\n", data->open_time);
+            printf("Close Time: %ld\n", data->close_time);
+            break;
+        case MARKET_EVENT_TICKER:
+            printf("Last Price: %.8f\n", data->price);
+            printf("Volume: %.8f\n", data->volume);
+            break;
+        case MARKET_EVENT_BOOK_TICKER:
+            if (data->bid_count > 0 && data->bid_quantities) {
+                printf("Best Bid: %.8f @ %.8f\n", data->bid_prices[0], data->bid_quantities[0]);
+            }
+            if (data->ask_count > 0 && data->ask_quantities) {
+                printf("Best Ask: %.8f @ %.8f\n", data->ask_prices[0], data->ask_quantities[0]);
+            }
+            break;
+        case MARKET_EVENT_DEPTH:
+            printf("Update IDs: %ld-%ld (prev %ld)\n", data->first_update_id,
+                   data->final_update_id, data->prev_final_update_id);
+            printf("Bids (%d):\n", data->bid_count);
+            for (int i = 0; i < data->bid_count && i < 5; i++) {
+                printf("  %.8f @ %.8f\n", data->bid_prices[i], data->bid_quantities[i]);
+            }
+            printf("Asks (%d):\n", data->ask_count);
+            for (int i = 0; i < data->ask_count && i < 5; i++) {
+                printf("  %.8f @ %.8f\n", data->ask_prices[i], data->ask_quantities[i]);
+            }
+            break;
+        default:
+            break;
     }
-    
+
+    if (data->receive_time_ns) {
+        printf("Receive Time: %lld ns\n", (long long)data->receive_time_ns);
+    }
+
     printf("==================\n");
 }
\ No newline at end of file
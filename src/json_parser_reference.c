@@ -0,0 +1,195 @@
+#include "json_parser.h"
+#include <json-c/json.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Reference parser used to cross-check the table driven fillers of json_parser.c.
+// Written out field by field with json_object_object_get_ex, and sharing none of
+// their field tables or store helpers, so a wrong table entry or conversion on
+// the fast path shows up as a difference instead of being repeated here.
+
+static char* reference_symbol(struct json_object *root) {
+    struct json_object *obj;
+    if (json_object_object_get_ex(root, "s", &obj) && json_object_is_type(obj, json_type_string)) {
+        return strdup(json_object_get_string(obj));
+    }
+    return NULL;
+}
+
+static void reference_int64(struct json_object *root, const char *key, long *out) {
+    struct json_object *obj;
+    if (json_object_object_get_ex(root, key, &obj)) {
+        *out = (long)json_object_get_int64(obj);
+    }
+}
+
+static void reference_double(struct json_object *root, const char *key, double *out) {
+    struct json_object *obj;
+    if (json_object_object_get_ex(root, key, &obj)) {
+        *out = json_object_get_double(obj);
+    }
+}
+
+// Single value book side of bookTicker, true if the key is present
+static bool reference_best(struct json_object *root, const char *key, double **out) {
+    struct json_object *obj;
+    if (!json_object_object_get_ex(root, key, &obj)) {
+        return false;
+    }
+    *out = (double *)malloc(sizeof(double));
+    if (*out) {
+        (*out)[0] = json_object_get_double(obj);
+    }
+    return true;
+}
+
+// [[price, quantity], ...] of depthUpdate, levels that are not pairs are skipped
+static void reference_levels(struct json_object *root, const char *key, double **prices,
+                             double **quantities, int *count) {
+    struct json_object *obj;
+    if (!json_object_object_get_ex(root, key, &obj) || !json_object_is_type(obj, json_type_array)) {
+        return;
+    }
+
+    size_t len = json_object_array_length(obj);
+    if (len == 0 || len > INT_MAX) {
+        return;
+    }
+
+    *prices = (double *)malloc(sizeof(double) * len);
+    *quantities = (double *)malloc(sizeof(double) * len);
+    if (!*prices || !*quantities) {
+        free(*prices);
+        free(*quantities);
+        *prices = NULL;
+        *quantities = NULL;
+        return;
+    }
+
+    int n = 0;
+    for (size_t i = 0; i < len; i++) {
+        struct json_object *level = json_object_array_get_idx(obj, i);
+        if (!json_object_is_type(level, json_type_array) || json_object_array_length(level) < 2) {
+            continue;
+        }
+        (*prices)[n] = json_object_get_double(json_object_array_get_idx(level, 0));
+        (*quantities)[n] = json_object_get_double(json_object_array_get_idx(level, 1));
+        n++;
+    }
+    *count = n;
+}
+
+market_data_t* parse_market_data_reference(const char *json_str, size_t len) {
+    if (!json_str || len > INT_MAX) {
+        return NULL;
+    }
+
+    // Fresh tokener, so the reference shares no parse state with the fast path
+    struct json_tokener *tok = json_tokener_new();
+    if (!tok) {
+        return NULL;
+    }
+    struct json_object *root = json_tokener_parse_ex(tok, json_str, (int)len);
+    json_tokener_free(tok);
+    if (!root) {
+        return NULL;
+    }
+    if (!json_object_is_type(root, json_type_object)) {
+        json_object_put(root);
+        return NULL;
+    }
+
+    market_data_t *data = (market_data_t *)calloc(1, sizeof(market_data_t));
+    if (!data) {
+        json_object_put(root);
+        return NULL;
+    }
+
+    struct json_object *obj;
+    const char *event_type = NULL;
+    if (json_object_object_get_ex(root, "e", &obj)) {
+        event_type = json_object_get_string(obj);
+    }
+    if (!event_type) {
+        // Errors and subscription responses carry no event
+        json_object_put(root);
+        return data;
+    }
+
+    if (strcmp(event_type, "aggTrade") == 0) {
+        data->event = MARKET_EVENT_AGG_TRADE;
+        data->symbol = reference_symbol(root);
+        reference_int64(root, "E", &data->event_time);
+        reference_double(root, "p", &data->price);
+        reference_double(root, "q", &data->quantity);
+        reference_int64(root, "T", &data->timestamp);
+        reference_int64(root, "a", &data->agg_trade_id);
+        reference_int64(root, "f", &data->first_trade_id);
+        reference_int64(root, "l", &data->last_trade_id);
+        if (json_object_object_get_ex(root, "m", &obj)) {
+            data->is_buyer_maker = json_object_get_boolean(obj);
+        }
+    } else if (strcmp(event_type, "markPriceUpdate") == 0) {
+        data->event = MARKET_EVENT_MARK_PRICE;
+        data->symbol = reference_symbol(root);
+        reference_int64(root, "E", &data->event_time);
+        reference_double(root, "p", &data->price);
+        reference_int64(root, "T", &data->timestamp);
+    } else if (strcmp(event_type, "kline") == 0) {
+        data->event = MARKET_EVENT_KLINE;
+        data->symbol = reference_symbol(root);
+        reference_int64(root, "E", &data->event_time);
+        if (json_object_object_get_ex(root, "k", &obj) && json_object_is_type(obj, json_type_object)) {
+            reference_int64(obj, "t", &data->open_time);
+            reference_double(obj, "o", &data->open);
+            reference_double(obj, "h", &data->high);
+            reference_double(obj, "l", &data->low);
+            reference_double(obj, "c", &data->close);
+            reference_double(obj, "v", &data->volume);
+            reference_int64(obj, "T", &data->close_time);
+        }
+    } else if (strcmp(event_type, "24hrTicker") == 0) {
+        data->event = MARKET_EVENT_TICKER;
+        data->symbol = reference_symbol(root);
+        reference_int64(root, "E", &data->event_time);
+        reference_double(root, "c", &data->price);
+        reference_double(root, "v", &data->volume);
+    } else if (strcmp(event_type, "bookTicker") == 0) {
+        data->event = MARKET_EVENT_BOOK_TICKER;
+        data->symbol = reference_symbol(root);
+        reference_int64(root, "E", &data->event_time);
+        reference_int64(root, "u", &data->final_update_id);
+        reference_int64(root, "T", &data->timestamp);
+        if (reference_best(root, "b", &data->bid_prices)) {
+            data->bid_count = 1;
+        }
+        reference_best(root, "B", &data->bid_quantities);
+        if (reference_best(root, "a", &data->ask_prices)) {
+            data->ask_count = 1;
+        }
+        reference_best(root, "A", &data->ask_quantities);
+    } else if (strcmp(event_type, "depthUpdate") == 0) {
+        data->event = MARKET_EVENT_DEPTH;
+        data->symbol = reference_symbol(root);
+        reference_int64(root, "E", &data->event_time);
+        reference_int64(root, "T", &data->timestamp);
+        reference_int64(root, "U", &data->first_update_id);
+        reference_int64(root, "u", &data->final_update_id);
+        reference_int64(root, "pu", &data->prev_final_update_id);
+        reference_levels(root, "b", &data->bid_prices, &data->bid_quantities, &data->bid_count);
+        reference_levels(root, "a", &data->ask_prices, &data->ask_quantities, &data->ask_count);
+    }
+    data->event_type = data->event != MARKET_EVENT_NONE ? market_event_name(data->event) : NULL;
+
+    // A side is only usable with both columns
+    if (!data->bid_prices || !data->bid_quantities) {
+        data->bid_count = 0;
+    }
+    if (!data->ask_prices || !data->ask_quantities) {
+        data->ask_count = 0;
+    }
+
+    json_object_put(root);
+    return data;
+}
\ No newline at end of file
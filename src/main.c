@@ -1,65 +1,155 @@
-#include "ws_client.h"
-#include "json_parser.h"
-#include "subscription.h"
+#include "cryptostream.h"
+#include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
 #include <getopt.h>
+#include <time.h>
 
-static ws_client_t *global_client = NULL;
+static cryptostream_t *global_stream = NULL;
+static app_config_t global_config;
+static tick_store_t *global_store = NULL;
+static analytics_t *global_analytics = NULL;
+static event_merger_t *global_merger = NULL;
+static const char *config_path = NULL;
+static int config_watch_fd = -1;
+static volatile sig_atomic_t reload_requested = 0;
+static int64_t metrics_logged_ns = 0;
+static int64_t exchange_time_ms = 0;
+static unsigned long late_events_skipped = 0;
+
+// Exchange stamps further ahead of our clock than this do not advance exchange_time_ms
+#define EXCHANGE_CLOCK_MAX_AHEAD_MS 10000
+
+// Streams used when the config file does not list any
+static const char *default_streams[] = {
+    "btcusdt@aggTrade",
+    "ethusdt@markPrice",
+    "btcusdt@kline_1m",
+    "btcusdt@ticker",
+    "btcusdt@bookTicker",
+};
 
 void signal_handler(int sig) {
     printf("\nReceived signal %d, shutting down...\n", sig);
-    if (global_client) {
-        ws_client_stop(global_client);
+    if (global_stream) {
+        cryptostream_stop(global_stream);
     }
 }
 
-void on_message(const char *data, size_t len) {
+void reload_signal_handler(int sig) {
+    (void)sig;
+    reload_requested = 1;
+}
+
+static int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void on_message(void *user, const char *data, size_t len) {
+    (void)user;
+    (void)len;
     printf("\nReceived message: %s\n", data);
-    
-    // Parse and print market data
-    market_data_t *market_data = parse_market_data(data, len);
-    if (market_data) {
-        print_market_data(market_data);
-        free_market_data(market_data);
+}
+
+// The sink sees every event in arrival order, reordering never costs a stored tick
+void record_market_data(const market_data_t *market_data) {
+    switch (global_config.sink) {
+        case SINK_STDOUT:
+            cryptostream_print_market_data(market_data);
+            break;
+        case SINK_STORE:
+            cryptostream_store_append(global_store, market_data);
+            break;
+        default:
+            break;
+    }
+}
+
+// Parsed by the library with the parser chosen for the stream set
+void on_market_data(void *user, const market_data_t *market_data, const char *data, size_t len) {
+    (void)user;
+    (void)data;
+    (void)len;
+    // Clock for expiring analytics windows, the exchange's rather than ours
+    long event_ms = market_data->event_time ? market_data->event_time : market_data->timestamp;
+    int64_t local_ms = market_data->receive_time_ns ? market_data->receive_time_ns / 1000000
+                                                    : (int64_t)time(NULL) * 1000;
+    if (event_ms > exchange_time_ms && event_ms <= local_ms + EXCHANGE_CLOCK_MAX_AHEAD_MS) {
+        exchange_time_ms = event_ms;
+    }
+    // Book imbalance from the synchronized book the diff was just applied to
+    if (market_data->event == MARKET_EVENT_DEPTH) {
+        cryptostream_analytics_update_book(global_analytics, market_data->symbol,
+                              cryptostream_book(global_stream, market_data->symbol),
+                              market_data->timestamp);
+    }
+    record_market_data(market_data);
+    // With a merger analytics take the event once it is released in exchange time order
+    if (!global_merger) {
+        cryptostream_analytics_update(global_analytics, market_data);
+    }
+}
+
+void on_merged_event(void *user, const market_data_t *market_data, bool late) {
+    (void)user;
+    // Windows already moved past a late event, so it is left out of analytics
+    // and only counted; the sink recorded it on arrival
+    if (late) {
+        late_events_skipped++;
+        return;
     }
+    cryptostream_analytics_update(global_analytics, market_data);
 }
 
-void on_connect(void) {
+void on_connect(void *user) {
+    (void)user;
     printf("Connected to Binance WebSocket\n");
-    
-    if (global_client) {
-        // Subscribe to multiple streams after connection
-        printf("Subscribing to streams...\n");
-        
-        // Example 1: Subscribe to BTC/USDT aggregate trades
-        ws_client_subscribe(global_client, "btcusdt@aggTrade");
-        
-        // Example 2: Subscribe to ETH/USDT mark price
-        ws_client_subscribe(global_client, "ethusdt@markPrice");
-        
-        // Example 3: Subscribe to BTC/USDT 1m klines
-        ws_client_subscribe(global_client, "btcusdt@kline_1m");
-        
-        // Example 4: Subscribe to BTC/USDT ticker
-        ws_client_subscribe(global_client, "btcusdt@ticker");
-        
-        // Example 5: Subscribe to BTC/USDT book ticker
-        ws_client_subscribe(global_client, "btcusdt@bookTicker");
-    }
-}
-
-void on_disconnect(void) {
+}
+
+void on_disconnect(void *user) {
+    (void)user;
     printf("Disconnected from Binance WebSocket\n");
 }
 
-void on_error(const char *error) {
+void on_sequence(void *user, const seq_event_t *event) {
+    (void)user;
+    const char *type = cryptostream_sequence_type_name(event->type);
+    switch (event->status) {
+        case SEQ_GAP:
+            fprintf(stderr, "Sequence gap on %s %s: expected %ld, got %ld (missing %ld)\n",
+                    event->symbol, type, event->expected, event->received, event->missing);
+            break;
+        case SEQ_TRADE_GAP:
+            fprintf(stderr, "Trade id gap on %s %s: expected f=%ld, got %ld (missing %ld)\n",
+                    event->symbol, type, event->expected, event->received, event->missing);
+            break;
+        case SEQ_DUPLICATE:
+            fprintf(stderr, "Duplicate %s %s id %ld\n", event->symbol, type, event->received);
+            break;
+        case SEQ_REORDER:
+            fprintf(stderr, "Out of order %s %s id %ld after %ld\n",
+                    event->symbol, type, event->received, event->expected);
+            break;
+        default:
+            break;
+    }
+}
+
+void on_error(void *user, const char *error) {
+    (void)user;
     fprintf(stderr, "WebSocket error: %s\n", error);
 }
 
+void on_log(void *user, const char *message) {
+    (void)user;
+    printf("%s\n", message);
+}
+
 void print_usage(const char *program_name) {
     printf("Usage: %s [OPTIONS]\n", program_name);
     printf("\nOptions:\n");
@@ -70,6 +160,7 @@ void print_usage(const char *program_name) {
     printf("  -u, --proxy-user USERNAME Proxy username (optional)\n");
     printf("  -w, --proxy-pass PASSWORD Proxy password (optional)\n");
     printf("  -c, --config FILE         Load configuration from file\n");
+    printf("                            (reloaded on SIGHUP or when the file changes)\n");
     printf("\nExamples:\n");
     printf("  %s                        # Direct connection\n", program_name);
     printf("  %s -p                     # Use proxy at 127.0.0.1:7890\n", program_name);
@@ -77,54 +168,110 @@ void print_usage(const char *program_name) {
     printf("  %s -c config.txt          # Load from config file\n", program_name);
 }
 
-void load_config_file(const char *filename, bool *use_proxy, char **proxy_addr, 
-                     int *proxy_port, char **proxy_user, char **proxy_pass) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Warning: Cannot open config file: %s\n", filename);
+void on_analytics_update(void *user, const analytics_snapshot_t *snapshot) {
+    (void)user;
+    if (global_config.sink != SINK_STDOUT) {
         return;
     }
-    
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline
-        line[strcspn(line, "\n")] = 0;
-        
-        // Skip comments and empty lines
-        if (line[0] == '#' || line[0] == '\0') {
-            continue;
+    printf("Analytics %s: vwap=%.8f micro=%.8f imb=%+.4f flow=%+.4f rvol=%.6f\n",
+           snapshot->symbol, snapshot->vwap, snapshot->microprice, snapshot->top_imbalance,
+           snapshot->trade_imbalance, snapshot->realized_vol);
+}
+
+// Open the tick store on first use of the store sink
+int open_sink(void) {
+    if (global_config.sink == SINK_STORE && !global_store) {
+        global_store = cryptostream_store_open(global_config.store_dir);
+        if (!global_store) {
+            fprintf(stderr, "Falling back to stdout sink\n");
+            global_config.sink = SINK_STDOUT;
+            return -1;
         }
-        
-        char key[64], value[192];
-        if (sscanf(line, "%63[^=]=%191s", key, value) == 2) {
-            if (strcmp(key, "use_proxy") == 0) {
-                *use_proxy = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
-            } else if (strcmp(key, "proxy_address") == 0) {
-                *proxy_addr = strdup(value);
-            } else if (strcmp(key, "proxy_port") == 0) {
-                *proxy_port = atoi(value);
-            } else if (strcmp(key, "proxy_username") == 0) {
-                *proxy_user = strdup(value);
-            } else if (strcmp(key, "proxy_password") == 0) {
-                *proxy_pass = strdup(value);
-            }
+    }
+    return 0;
+}
+
+// Re-read config file and apply what can change without reconnecting
+void reload_config(void) {
+    app_config_t next;
+    config_init(&next);
+    if (config_load_file(config_path, &next) < 0) {
+        fprintf(stderr, "Config reload failed, keeping current settings\n");
+        config_free(&next);
+        return;
+    }
+
+    if (next.stream_count == 0) {
+        for (size_t i = 0; i < sizeof(default_streams) / sizeof(default_streams[0]); i++) {
+            config_add_stream(&next, default_streams[i]);
+        }
+    }
+
+    if (config_needs_restart(&global_config, &next) ||
+        (global_store && strcmp(next.store_dir, global_config.store_dir) != 0)) {
+        printf("Proxy, queue, socket, store, analytics, metrics port, REST and merge settings take effect on restart\n");
+    }
+
+    // Only the difference is sent, books follow the new depth streams
+    cryptostream_set_streams(global_stream, (const char **)next.streams, next.stream_count);
+
+    // Swap in new stream set and sink, keep connection level settings
+    for (int i = 0; i < global_config.stream_count; i++) {
+        free(global_config.streams[i]);
+    }
+    memcpy(global_config.streams, next.streams, sizeof(next.streams));
+    global_config.stream_count = next.stream_count;
+    next.stream_count = 0;
+    // Leaving the store sink: get what was recorded so far on disk
+    if (global_store && global_config.sink == SINK_STORE && next.sink != SINK_STORE) {
+        cryptostream_store_sync(global_store);
+    }
+    global_config.sink = next.sink;
+    global_config.parser_check = next.parser_check;
+    cryptostream_set_parser_check(global_stream, global_config.parser_check);
+    global_config.metrics_log_interval = next.metrics_log_interval;
+    if (!global_store) {
+        free(global_config.store_dir);
+        global_config.store_dir = next.store_dir;
+        next.store_dir = NULL;
+    }
+    open_sink();
+
+    config_free(&next);
+    printf("Configuration reloaded\n");
+}
+
+void on_tick(void *user) {
+    (void)user;
+    if (config_watch_changed(config_watch_fd, config_path)) {
+        reload_requested = 1;
+    }
+
+    if (reload_requested && config_path) {
+        reload_requested = 0;
+        reload_config();
+    }
+
+    // Windows of symbols without new trades age out against the newest event of any stream
+    if (exchange_time_ms > 0) {
+        cryptostream_analytics_expire(global_analytics, exchange_time_ms);
+    }
+
+    if (global_config.metrics_log_interval > 0) {
+        int64_t now = monotonic_ns();
+        if (now - metrics_logged_ns >= (int64_t)global_config.metrics_log_interval * 1000000000LL) {
+            cryptostream_metrics_log(stdout);
+            metrics_logged_ns = now;
         }
     }
-    
-    fclose(file);
-    printf("Configuration loaded from %s\n", filename);
 }
 
 int main(int argc, char *argv[]) {
     printf("Binance WebSocket Client\n");
     printf("========================\n\n");
     
-    // Default proxy settings
-    bool use_proxy = false;
-    char *proxy_address = NULL;
-    int proxy_port = 7890;
-    char *proxy_username = NULL;
-    char *proxy_password = NULL;
+    // Default settings
+    config_init(&global_config);
     char *config_file = NULL;
     
     // Parse command line options
@@ -146,24 +293,28 @@ int main(int argc, char *argv[]) {
                 print_usage(argv[0]);
                 return 0;
             case 'p':
-                use_proxy = true;
-                if (!proxy_address) {
-                    proxy_address = strdup("127.0.0.1");
+                global_config.use_proxy = true;
+                if (!global_config.proxy_address) {
+                    global_config.proxy_address = strdup("127.0.0.1");
                 }
                 break;
             case 'a':
-                proxy_address = strdup(optarg);
+                free(global_config.proxy_address);
+                global_config.proxy_address = strdup(optarg);
                 break;
             case 'P':
-                proxy_port = atoi(optarg);
+                global_config.proxy_port = atoi(optarg);
                 break;
             case 'u':
-                proxy_username = strdup(optarg);
+                free(global_config.proxy_username);
+                global_config.proxy_username = strdup(optarg);
                 break;
             case 'w':
-                proxy_password = strdup(optarg);
+                free(global_config.proxy_password);
+                global_config.proxy_password = strdup(optarg);
                 break;
             case 'c':
+                free(config_file);
                 config_file = strdup(optarg);
                 break;
             default:
@@ -174,62 +325,129 @@ int main(int argc, char *argv[]) {
     
     // Load config file if specified
     if (config_file) {
-        load_config_file(config_file, &use_proxy, &proxy_address, 
-                        &proxy_port, &proxy_username, &proxy_password);
-        free(config_file);
+        config_path = config_file;
+        config_load_file(config_file, &global_config);
+        config_watch_fd = config_watch(config_file);
+    }
+    
+    if (global_config.stream_count == 0) {
+        for (size_t i = 0; i < sizeof(default_streams) / sizeof(default_streams[0]); i++) {
+            config_add_stream(&global_config, default_streams[i]);
+        }
+    }
+    
+    open_sink();
+    if (global_config.analytics) {
+        global_analytics = cryptostream_analytics_create(global_config.analytics_window_ms,
+                                            (uint32_t)global_config.analytics_window_trades,
+                                            on_analytics_update, NULL);
+    }
+    if (global_config.event_merge) {
+        global_merger = cryptostream_merger_create(global_config.merge_window_ms,
+                                            global_config.merge_max_lateness_ms,
+                                            global_config.merge_capacity > 0 ?
+                                                (size_t)global_config.merge_capacity : 0,
+                                            on_merged_event, NULL);
+        if (global_merger) {
+            printf("Ordering analytics input by exchange time (window %d ms, lateness %d ms)\n",
+                   global_config.merge_window_ms, global_config.merge_max_lateness_ms);
+        }
     }
     
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGHUP, reload_signal_handler);
     
     // Create WebSocket client
     const char *server = "fstream.binance.com";
     int port = 443;
     const char *path = "/ws";
     
-    global_client = ws_client_create(server, port, path);
-    if (!global_client) {
+    global_stream = cryptostream_create(server, port, path);
+    if (!global_stream) {
         fprintf(stderr, "Failed to create WebSocket client\n");
         return 1;
     }
     
+    // Set callbacks first so the settings below can already report status
+    cryptostream_callbacks_t callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.on_message = on_message;
+    callbacks.on_market_data = on_market_data;
+    callbacks.on_connect = on_connect;
+    callbacks.on_disconnect = on_disconnect;
+    callbacks.on_error = on_error;
+    callbacks.on_tick = on_tick;
+    callbacks.on_log = on_log;
+    callbacks.on_sequence = on_sequence;
+    cryptostream_set_callbacks(global_stream, &callbacks, NULL);
+    
     // Configure proxy if enabled
-    if (use_proxy) {
+    if (global_config.use_proxy) {
         printf("\n=== Proxy Configuration ===\n");
-        ws_client_set_proxy(global_client, proxy_address, proxy_port, 
-                           proxy_username, proxy_password);
+        cryptostream_set_proxy(global_stream, global_config.proxy_address, global_config.proxy_port,
+                               global_config.proxy_username, global_config.proxy_password);
         printf("===========================\n\n");
     } else {
         printf("Using direct connection (no proxy)\n\n");
     }
     
-    // Set callbacks
-    global_client->on_message = on_message;
-    global_client->on_connect = on_connect;
-    global_client->on_disconnect = on_disconnect;
-    global_client->on_error = on_error;
+    // Receive path tuning
+    cryptostream_set_socket_tuning(global_stream, &global_config.socket);
+    cryptostream_set_cpu_affinity(global_stream, global_config.cpu_affinity);
+    cryptostream_set_send_queue_size(global_stream, global_config.send_queue_size);
+    cryptostream_set_metrics_port(global_stream, global_config.metrics_port);
+    if (global_config.depth_books) {
+        cryptostream_set_depth_books(global_stream, global_config.rest_host,
+                                     global_config.rest_port, global_config.rest_tls,
+                                     global_config.depth_snapshot_limit,
+                                     global_config.rest_max_in_flight,
+                                     global_config.rest_weight_limit);
+    }
+    cryptostream_set_merger(global_stream, global_merger);
+    cryptostream_set_parser_check(global_stream, global_config.parser_check);
+    cryptostream_set_streams(global_stream, (const char **)global_config.streams,
+                             global_config.stream_count);
     
     // Connect to server
     printf("Connecting to %s:%d%s\n", server, port, path);
-    if (ws_client_connect(global_client) < 0) {
+    if (cryptostream_connect(global_stream) < 0) {
         fprintf(stderr, "Failed to connect to WebSocket server\n");
-        ws_client_destroy(global_client);
+        cryptostream_destroy(global_stream);
         return 1;
     }
     
-    // Run event loop
+    // Run event loop on this thread
     printf("Starting event loop (Press Ctrl+C to stop)...\n\n");
-    ws_client_run(global_client);
+    metrics_logged_ns = monotonic_ns();
+    cryptostream_run(global_stream);
     
     // Cleanup
     printf("Cleaning up...\n");
-    ws_client_destroy(global_client);
+    cryptostream_print_books(global_stream);
+    cryptostream_print_sequence(global_stream);
+    cryptostream_print_parser_check(global_stream);
+    cryptostream_destroy(global_stream);
+    // Events still waiting in the reorder window reach the sinks before they close
+    cryptostream_merger_flush(global_merger);
+    
+    cryptostream_store_close(global_store);
+    cryptostream_analytics_print(global_analytics);
+    if (global_merger) {
+        printf("Late events left out of analytics: %lu\n", late_events_skipped);
+    }
+    cryptostream_analytics_destroy(global_analytics);
+    cryptostream_merger_print(global_merger);
+    cryptostream_merger_destroy(global_merger);
+    cryptostream_metrics_log(stdout);
+    cryptostream_metrics_shutdown();
     
-    // Free proxy settings
-    free(proxy_address);
-    free(proxy_username);
-    free(proxy_password);
+    if (config_watch_fd >= 0) {
+        close(config_watch_fd);
+    }
+    free(config_file);
+    config_free(&global_config);
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "metrics.h"
+#include "symbol_hash.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_MASK (METRICS_MAX_STREAMS - 1)
+
+_Thread_local metrics_shard_t *metrics_thread_shard = NULL;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static metrics_shard_t *shards = NULL;
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static _Atomic int64_t gauges[METRIC_GAUGE_COUNT];
+
+// Stream table: entries are written once under registry_lock and published by
+// a release store of `ready`, so lookups need no lock
+static char stream_symbols[METRICS_MAX_STREAMS][METRICS_SYMBOL_SIZE];
+static market_event_t stream_events[METRICS_MAX_STREAMS];
+static atomic_bool stream_ready[METRICS_MAX_STREAMS];
+static int stream_count = 0;
+
+// Values at the previous log line, for rates
+static uint64_t logged_messages = 0;
+static uint64_t logged_bytes = 0;
+static int64_t logged_at_ns = 0;   // first shard registration until the first line
+
+static const char *counter_names[METRIC_COUNTER_COUNT] = {
+#define X(id, name, help) name,
+    METRIC_COUNTERS(X)
+#undef X
+};
+
+static const char *counter_help[METRIC_COUNTER_COUNT] = {
+#define X(id, name, help) help,
+    METRIC_COUNTERS(X)
+#undef X
+};
+
+static const char *gauge_names[METRIC_GAUGE_COUNT] = {
+#define X(id, name, help) name,
+    METRIC_GAUGES(X)
+#undef X
+};
+
+static const char *gauge_help[METRIC_GAUGE_COUNT] = {
+#define X(id, name, help) help,
+    METRIC_GAUGES(X)
+#undef X
+};
+
+// Thread exit: the shard is no longer referenced and may be freed on shutdown
+static void shard_thread_exit(void *value) {
+    metrics_shard_t *shard = (metrics_shard_t *)value;
+    pthread_mutex_lock(&registry_lock);
+    shard->exited = true;
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static void create_exit_key(void) {
+    pthread_key_create(&exit_key, shard_thread_exit);
+}
+
+metrics_shard_t* metrics_attach_thread(void) {
+    if (metrics_thread_shard) {
+        return metrics_thread_shard;
+    }
+
+    metrics_shard_t *shard = (metrics_shard_t *)calloc(1, sizeof(metrics_shard_t));
+    if (!shard) {
+        return NULL;
+    }
+
+    // Shards outlive their thread so its counts stay in the totals
+    pthread_mutex_lock(&registry_lock);
+    shard->next = shards;
+    shards = shard;
+    if (!logged_at_ns) {
+        logged_at_ns = metrics_clock_ns();
+    }
+    pthread_mutex_unlock(&registry_lock);
+
+    pthread_once(&exit_key_once, create_exit_key);
+    pthread_setspecific(exit_key, shard);
+    metrics_thread_shard = shard;
+    return shard;
+}
+
+void metrics_gauge_set(metric_gauge_t id, int64_t value) {
+    atomic_store_explicit(&gauges[id], value, memory_order_relaxed);
+}
+
+static int find_stream(const char *symbol, market_event_t event, unsigned int *slot_out) {
+    unsigned int slot = symbol_hash(symbol, (unsigned int)event) & STREAM_MASK;
+
+    for (int probe = 0; probe < METRICS_MAX_STREAMS; probe++) {
+        if (!atomic_load_explicit(&stream_ready[slot], memory_order_acquire)) {
+            *slot_out = slot;
+            return 0;
+        }
+        if (stream_events[slot] == event && strcmp(stream_symbols[slot], symbol) == 0) {
+            *slot_out = slot;
+            return 1;
+        }
+        slot = (slot + 1) & STREAM_MASK;
+    }
+    return -1;
+}
+
+static int stream_slot(const char *symbol, market_event_t event) {
+    unsigned int slot;
+    if (find_stream(symbol, event, &slot) == 1) {
+        return (int)slot;
+    }
+
+    // First message of this stream: insert under the lock, re-probing in case
+    // another thread got there first
+    int result = -1;
+    pthread_mutex_lock(&registry_lock);
+    int found = find_stream(symbol, event, &slot);
+    if (found == 1) {
+        result = (int)slot;
+    } else if (found == 0 && stream_count < METRICS_MAX_STREAMS - 1) {
+        // Keep one slot free so probing always terminates
+        snprintf(stream_symbols[slot], METRICS_SYMBOL_SIZE, "%s", symbol);
+        stream_events[slot] = event;
+        atomic_store_explicit(&stream_ready[slot], true, memory_order_release);
+        stream_count++;
+        result = (int)slot;
+    }
+    pthread_mutex_unlock(&registry_lock);
+    return result;
+}
+
+void metrics_record_stream(const char *symbol, market_event_t event, size_t len) {
+    if (!symbol) {
+        return;
+    }
+
+    metrics_shard_t *shard = metrics_thread_shard ? metrics_thread_shard : metrics_attach_thread();
+    int slot = stream_slot(symbol, event);
+    if (!shard || slot < 0) {
+        return;
+    }
+
+    uint64_t messages = atomic_load_explicit(&shard->stream_messages[slot], memory_order_relaxed);
+    uint64_t bytes = atomic_load_explicit(&shard->stream_bytes[slot], memory_order_relaxed);
+    atomic_store_explicit(&shard->stream_messages[slot], messages + 1, memory_order_relaxed);
+    atomic_store_explicit(&shard->stream_bytes[slot], bytes + len, memory_order_relaxed);
+}
+
+// Sum one column over all shards, caller holds registry_lock
+static uint64_t sum_locked(size_t offset, int index) {
+    uint64_t sum = 0;
+    for (metrics_shard_t *shard = shards; shard; shard = shard->next) {
+        _Atomic uint64_t *column = (_Atomic uint64_t *)((char *)shard + offset);
+        sum += atomic_load_explicit(&column[index], memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t metrics_counter_value(metric_counter_t id) {
+    pthread_mutex_lock(&registry_lock);
+    uint64_t sum = sum_locked(offsetof(metrics_shard_t, counters), id);
+    pthread_mutex_unlock(&registry_lock);
+    return sum;
+}
+
+int64_t metrics_gauge_value(metric_gauge_t id) {
+    return atomic_load_explicit(&gauges[id], memory_order_relaxed);
+}
+
+// Label value with the characters Prometheus requires escaped
+static void write_label(FILE *out, const char *value) {
+    for (const char *c = value; *c; c++) {
+        if (*c == '\\' || *c == '"') {
+            fputc('\\', out);
+            fputc(*c, out);
+        } else if (*c == '\n') {
+            fputs("\\n", out);
+        } else {
+            fputc(*c, out);
+        }
+    }
+}
+
+// One per-stream sample line
+static void write_stream_sample(FILE *out, const char *name, int slot, uint64_t value) {
+    fprintf(out, "%s{symbol=\"", name);
+    write_label(out, stream_symbols[slot]);
+    fprintf(out, "\",event=\"%s\"} %llu\n", market_event_name(stream_events[slot]),
+            (unsigned long long)value);
+}
+
+char* metrics_prometheus_text(size_t *len) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    if (!out) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&registry_lock);
+
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                counter_names[i], counter_help[i], counter_names[i], counter_names[i],
+                (unsigned long long)sum_locked(offsetof(metrics_shard_t, counters), i));
+    }
+
+    for (int i = 0; i < METRIC_GAUGE_COUNT; i++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %lld\n",
+                gauge_names[i], gauge_help[i], gauge_names[i], gauge_names[i],
+                (long long)atomic_load_explicit(&gauges[i], memory_order_relaxed));
+    }
+
+    fprintf(out, "# HELP cryptostream_stream_messages_total Messages per stream\n"
+                 "# TYPE cryptostream_stream_messages_total counter\n");
+    for (int i = 0; i < METRICS_MAX_STREAMS; i++) {
+        if (atomic_load_explicit(&stream_ready[i], memory_order_acquire)) {
+            write_stream_sample(out, "cryptostream_stream_messages_total", i,
+                                sum_locked(offsetof(metrics_shard_t, stream_messages), i));
+        }
+    }
+
+    fprintf(out, "# HELP cryptostream_stream_bytes_total Payload bytes per stream\n"
+                 "# TYPE cryptostream_stream_bytes_total counter\n");
+    for (int i = 0; i < METRICS_MAX_STREAMS; i++) {
+        if (atomic_load_explicit(&stream_ready[i], memory_order_acquire)) {
+            write_stream_sample(out, "cryptostream_stream_bytes_total", i,
+                                sum_locked(offsetof(metrics_shard_t, stream_bytes), i));
+        }
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+
+    if (fclose(out) != 0) {
+        free(text);
+        return NULL;
+    }
+    if (len) {
+        *len = size;
+    }
+    return text;
+}
+
+void metrics_log_line(FILE *out) {
+    uint64_t counters[METRIC_COUNTER_COUNT];
+
+    int64_t now = metrics_clock_ns();
+    pthread_mutex_lock(&registry_lock);
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        counters[i] = sum_locked(offsetof(metrics_shard_t, counters), i);
+    }
+    double seconds = logged_at_ns ? (double)(now - logged_at_ns) / 1e9 : 0.0;
+    uint64_t previous_messages = logged_messages;
+    uint64_t previous_bytes = logged_bytes;
+    logged_messages = counters[METRIC_MESSAGES_RECEIVED];
+    logged_bytes = counters[METRIC_BYTES_RECEIVED];
+    logged_at_ns = now;
+    pthread_mutex_unlock(&registry_lock);
+
+    uint64_t iterations = counters[METRIC_LOOP_ITERATIONS];
+
+    fprintf(out, "[metrics] msgs=%llu (%.0f/s) bytes=%llu (%.0f/s) sent=%llu parse_fail=%llu "
+                 "seq=%llu drops=%llu conn=%llu/%llu q=%lld subs=%lld loop_avg=%.1fus allocs=%llu\n",
+            (unsigned long long)counters[METRIC_MESSAGES_RECEIVED],
+            seconds > 0.0 ? (double)(counters[METRIC_MESSAGES_RECEIVED] - previous_messages) / seconds : 0.0,
+            (unsigned long long)counters[METRIC_BYTES_RECEIVED],
+            seconds > 0.0 ? (double)(counters[METRIC_BYTES_RECEIVED] - previous_bytes) / seconds : 0.0,
+            (unsigned long long)counters[METRIC_MESSAGES_SENT],
+            (unsigned long long)counters[METRIC_PARSE_FAILURES],
+            (unsigned long long)counters[METRIC_SEQUENCE_ANOMALIES],
+            (unsigned long long)(counters[METRIC_SEND_DROPS] + counters[METRIC_FRAMES_DROPPED]),
+            (unsigned long long)counters[METRIC_CONNECTS],
+            (unsigned long long)counters[METRIC_DISCONNECTS],
+            (long long)metrics_gauge_value(METRIC_SEND_QUEUE_DEPTH),
+            (long long)metrics_gauge_value(METRIC_SUBSCRIPTIONS),
+            iterations ? (double)counters[METRIC_LOOP_NANOSECONDS] / (double)iterations / 1e3 : 0.0,
+            (unsigned long long)counters[METRIC_ALLOCATIONS]);
+}
+
+void metrics_shutdown(void) {
+    metrics_shard_t *own = metrics_thread_shard;
+
+    // Other running threads hold their shard in thread local storage without
+    // the lock, so only unreferenced shards are freed
+    pthread_mutex_lock(&registry_lock);
+    metrics_shard_t **link = &shards;
+    while (*link) {
+        metrics_shard_t *shard = *link;
+        if (shard == own || shard->exited) {
+            *link = shard->next;
+            free(shard);
+            continue;
+        }
+        for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+            atomic_store_explicit(&shard->counters[i], 0, memory_order_relaxed);
+        }
+        for (int i = 0; i < METRICS_MAX_STREAMS; i++) {
+            atomic_store_explicit(&shard->stream_messages[i], 0, memory_order_relaxed);
+            atomic_store_explicit(&shard->stream_bytes[i], 0, memory_order_relaxed);
+        }
+        link = &shard->next;
+    }
+    logged_messages = 0;
+    logged_bytes = 0;
+    logged_at_ns = 0;
+    pthread_mutex_unlock(&registry_lock);
+
+    // Threads that record again attach a fresh shard
+    if (own) {
+        pthread_setspecific(exit_key, NULL);
+    }
+    metrics_thread_shard = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "metrics_http.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METRICS_HTTP_CHUNK 4096
+
+typedef struct {
+    char *body;
+    size_t len;
+    size_t sent;
+} metrics_session_t;
+
+static int finish_transaction(struct lws *wsi) {
+    // Keep-alive: ready for the next request, or close if lws says so
+    return lws_http_transaction_completed(wsi) ? -1 : 0;
+}
+
+static int callback_metrics_http(struct lws *wsi, enum lws_callback_reasons reason,
+                                 void *user, void *in, size_t len) {
+    metrics_session_t *session = (metrics_session_t *)user;
+    
+    switch (reason) {
+        case LWS_CALLBACK_HTTP: {
+            if (!in || strcmp((const char *)in, "/metrics") != 0) {
+                lws_return_http_status(wsi, HTTP_STATUS_NOT_FOUND, NULL);
+                return finish_transaction(wsi);
+            }
+            
+            // Render once per request, then stream it out on WRITEABLE
+            free(session->body);
+            session->body = metrics_prometheus_text(&session->len);
+            session->sent = 0;
+            if (!session->body) {
+                lws_return_http_status(wsi, HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL);
+                return finish_transaction(wsi);
+            }
+            
+            unsigned char headers[LWS_PRE + 512];
+            unsigned char *start = &headers[LWS_PRE];
+            unsigned char *p = start;
+            unsigned char *end = &headers[sizeof(headers) - 1];
+            if (lws_add_http_common_headers(wsi, HTTP_STATUS_OK, "text/plain; version=0.0.4",
+                                            session->len, &p, end) ||
+                lws_finalize_write_http_header(wsi, start, &p, end)) {
+                return 1;
+            }
+            lws_callback_on_writable(wsi);
+            return 0;
+        }
+            
+        case LWS_CALLBACK_HTTP_WRITEABLE: {
+            if (!session || !session->body) {
+                break;
+            }
+            
+            size_t chunk = session->len - session->sent;
+            if (chunk > METRICS_HTTP_CHUNK) {
+                chunk = METRICS_HTTP_CHUNK;
+            }
+            bool final = session->sent + chunk == session->len;
+            
+            // lws_write needs LWS_PRE writable bytes in front of the payload
+            unsigned char buf[LWS_PRE + METRICS_HTTP_CHUNK];
+            memcpy(&buf[LWS_PRE], session->body + session->sent, chunk);
+            if (lws_write(wsi, &buf[LWS_PRE], chunk,
+                          final ? LWS_WRITE_HTTP_FINAL : LWS_WRITE_HTTP) != (int)chunk) {
+                return 1;
+            }
+            session->sent += chunk;
+            
+            if (!final) {
+                lws_callback_on_writable(wsi);
+                return 0;
+            }
+            free(session->body);
+            session->body = NULL;
+            return finish_transaction(wsi);
+        }
+            
+        case LWS_CALLBACK_CLOSED_HTTP:
+            if (session) {
+                free(session->body);
+                session->body = NULL;
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    return lws_callback_http_dummy(wsi, reason, user, in, len);
+}
+
+static const struct lws_protocols metrics_protocols[] = {
+    {
+        "metrics-http",
+        callback_metrics_http,
+        sizeof(metrics_session_t),
+        0,
+    },
+    { NULL, NULL, 0, 0 }
+};
+
+int metrics_http_listen(struct lws_context *context, const char *iface, int port) {
+    struct lws_context_creation_info info;
+    memset(&info, 0, sizeof(info));
+    
+    info.port = port;
+    info.iface = iface;
+    info.protocols = metrics_protocols;
+    info.vhost_name = "metrics";
+    
+    if (!lws_create_vhost(context, &info)) {
+        fprintf(stderr, "Failed to listen for metrics on %s:%d\n", iface, port);
+        return -1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "order_book.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Index of price in side, or where it would be inserted
+static int find_level(const book_side_t *side, bool bid, double price, bool *found) {
+    int lo = 0;
+    int hi = side->count;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        double level = side->prices[mid];
+        if (level == price) {
+            *found = true;
+            return mid;
+        }
+        // Bids descend, asks ascend
+        if (bid ? level > price : level < price) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *found = false;
+    return lo;
+}
+
+static int reserve(book_side_t *side, int needed) {
+    if (needed <= side->capacity) {
+        return 0;
+    }
+
+    int capacity = side->capacity ? side->capacity : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    double *prices = (double *)realloc(side->prices, sizeof(double) * capacity);
+    if (!prices) {
+        return -1;
+    }
+    side->prices = prices;
+
+    double *quantities = (double *)realloc(side->quantities, sizeof(double) * capacity);
+    if (!quantities) {
+        return -1;
+    }
+    side->quantities = quantities;
+    side->capacity = capacity;
+    return 0;
+}
+
+int order_book_set(order_book_t *book, bool bid, double price, double quantity) {
+    book_side_t *side = bid ? &book->bids : &book->asks;
+    bool found;
+    int i = find_level(side, bid, price, &found);
+
+    if (quantity <= 0.0) {
+        if (found) {
+            memmove(&side->prices[i], &side->prices[i + 1], sizeof(double) * (side->count - i - 1));
+            memmove(&side->quantities[i], &side->quantities[i + 1],
+                    sizeof(double) * (side->count - i - 1));
+            side->count--;
+        }
+        return 0;
+    }
+
+    if (found) {
+        side->quantities[i] = quantity;
+        return 0;
+    }
+
+    if (reserve(side, side->count + 1) < 0) {
+        return -1;
+    }
+    memmove(&side->prices[i + 1], &side->prices[i], sizeof(double) * (side->count - i));
+    memmove(&side->quantities[i + 1], &side->quantities[i], sizeof(double) * (side->count - i));
+    side->prices[i] = price;
+    side->quantities[i] = quantity;
+    side->count++;
+    return 0;
+}
+
+int order_book_load(order_book_t *book, const double *bid_prices, const double *bid_quantities,
+                    int bid_count, const double *ask_prices, const double *ask_quantities,
+                    int ask_count, long last_update_id) {
+    order_book_clear(book);
+
+    for (int i = 0; i < bid_count; i++) {
+        if (order_book_set(book, true, bid_prices[i], bid_quantities[i]) < 0) {
+            return -1;
+        }
+    }
+    for (int i = 0; i < ask_count; i++) {
+        if (order_book_set(book, false, ask_prices[i], ask_quantities[i]) < 0) {
+            return -1;
+        }
+    }
+
+    book->last_update_id = last_update_id;
+    return 0;
+}
+
+void order_book_clear(order_book_t *book) {
+    book->bids.count = 0;
+    book->asks.count = 0;
+    book->last_update_id = 0;
+}
+
+static bool best(const book_side_t *side, double *price, double *quantity) {
+    if (side->count == 0) {
+        return false;
+    }
+    if (price) {
+        *price = side->prices[0];
+    }
+    if (quantity) {
+        *quantity = side->quantities[0];
+    }
+    return true;
+}
+
+bool order_book_best_bid(const order_book_t *book, double *price, double *quantity) {
+    return best(&book->bids, price, quantity);
+}
+
+bool order_book_best_ask(const order_book_t *book, double *price, double *quantity) {
+    return best(&book->asks, price, quantity);
+}
+
+void order_book_free(order_book_t *book) {
+    free(book->bids.prices);
+    free(book->bids.quantities);
+    free(book->asks.prices);
+    free(book->asks.quantities);
+    memset(book, 0, sizeof(*book));
+}
\ No newline at end of file
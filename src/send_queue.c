@@ -0,0 +1,129 @@
+#include "send_queue.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Slot protocol (bounded queue after D. Vyukov): slot i is free for the producer
+// holding position p when sequences[i] == p, and holds a message for the consumer
+// at position p when sequences[i] == p + 1.
+
+send_queue_t* send_queue_create(size_t capacity, size_t headroom) {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+
+    send_queue_t *queue = (send_queue_t *)aligned_alloc(64, (sizeof(send_queue_t) + 63) & ~(size_t)63);
+    if (!queue) {
+        return NULL;
+    }
+    memset(queue, 0, sizeof(*queue));
+
+    queue->capacity = rounded;
+    queue->headroom = headroom;
+    queue->stride = (headroom + SEND_QUEUE_MESSAGE_SIZE + 15) & ~(size_t)15;
+    queue->sequences = (_Atomic size_t *)calloc(rounded, sizeof(*queue->sequences));
+    queue->lengths = (size_t *)calloc(rounded, sizeof(size_t));
+    queue->slots = (unsigned char *)malloc(rounded * queue->stride);
+    if (!queue->sequences || !queue->lengths || !queue->slots) {
+        send_queue_destroy(queue);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < rounded; i++) {
+        atomic_init(&queue->sequences[i], i);
+    }
+    atomic_init(&queue->enqueue_pos, 0);
+    queue->dequeue_pos = 0;
+    return queue;
+}
+
+int send_queue_push(send_queue_t *queue, const void *data, size_t len) {
+    if (!queue || len > SEND_QUEUE_MESSAGE_SIZE) {
+        return -1;
+    }
+
+    size_t mask = queue->capacity - 1;
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    size_t slot;
+
+    for (;;) {
+        slot = pos & mask;
+        size_t seq = atomic_load_explicit(&queue->sequences[slot], memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // Slot is free for this position, claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Consumer has not released this slot yet: full
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(queue->slots + slot * queue->stride + queue->headroom, data, len);
+    queue->lengths[slot] = len;
+    atomic_store_explicit(&queue->sequences[slot], pos + 1, memory_order_release);
+    return 0;
+}
+
+unsigned char* send_queue_peek(send_queue_t *queue, size_t *len) {
+    if (!queue) {
+        return NULL;
+    }
+
+    size_t pos = queue->dequeue_pos;
+    size_t slot = pos & (queue->capacity - 1);
+    size_t seq = atomic_load_explicit(&queue->sequences[slot], memory_order_acquire);
+    if (seq != pos + 1) {
+        return NULL;
+    }
+
+    if (len) {
+        *len = queue->lengths[slot];
+    }
+    return queue->slots + slot * queue->stride + queue->headroom;
+}
+
+void send_queue_pop(send_queue_t *queue) {
+    if (!send_queue_peek(queue, NULL)) {
+        return;
+    }
+
+    size_t pos = queue->dequeue_pos;
+    size_t slot = pos & (queue->capacity - 1);
+    // Hand the slot back to producers one lap ahead
+    atomic_store_explicit(&queue->sequences[slot], pos + queue->capacity, memory_order_release);
+    queue->dequeue_pos = pos + 1;
+}
+
+size_t send_queue_depth(send_queue_t *queue) {
+    if (!queue) {
+        return 0;
+    }
+
+    size_t enqueued = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    return enqueued - queue->dequeue_pos;
+}
+
+void send_queue_clear(send_queue_t *queue) {
+    while (send_queue_peek(queue, NULL)) {
+        send_queue_pop(queue);
+    }
+}
+
+void send_queue_destroy(send_queue_t *queue) {
+    if (!queue) {
+        return;
+    }
+
+    free((void *)queue->sequences);
+    free(queue->lengths);
+    free(queue->slots);
+    free(queue);
+}
\ No newline at end of file
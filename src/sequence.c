@@ -0,0 +1,259 @@
+#include "sequence.h"
+#include "symbol_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *stream_type_names[SEQ_STREAM_TYPES] = {
+    "aggTrade",
+    "bookTicker",
+    "depthUpdate",
+};
+
+const char* seq_stream_type_name(seq_stream_type_t type) {
+    if (type < 0 || type >= SEQ_STREAM_TYPES) {
+        return "unknown";
+    }
+    return stream_type_names[type];
+}
+
+seq_tracker_t* seq_tracker_create(void (*on_event)(void *user, const seq_event_t *event),
+                                  void *user) {
+    seq_tracker_t *tracker = (seq_tracker_t *)calloc(1, sizeof(seq_tracker_t));
+    if (!tracker) {
+        return NULL;
+    }
+
+    tracker->on_event = on_event;
+    tracker->user = user;
+    return tracker;
+}
+
+static seq_stream_t* lookup_stream(const seq_tracker_t *tracker, const char *symbol,
+                                   seq_stream_type_t type, bool *found) {
+    unsigned int slot = symbol_hash(symbol, (unsigned int)type) & (SEQ_MAX_STREAMS - 1);
+
+    for (int probe = 0; probe < SEQ_MAX_STREAMS; probe++) {
+        seq_stream_t *stream = (seq_stream_t *)&tracker->streams[slot];
+        if (!stream->in_use) {
+            *found = false;
+            return stream;
+        }
+        if (stream->type == type && strcmp(stream->symbol, symbol) == 0) {
+            *found = true;
+            return stream;
+        }
+        slot = (slot + 1) & (SEQ_MAX_STREAMS - 1);
+    }
+
+    *found = false;
+    return NULL;
+}
+
+static seq_stream_t* get_stream(seq_tracker_t *tracker, const char *symbol,
+                                seq_stream_type_t type) {
+    bool found;
+    seq_stream_t *stream = lookup_stream(tracker, symbol, type, &found);
+    if (found) {
+        return stream;
+    }
+
+    // Keep one slot free so probing always terminates
+    if (!stream || tracker->stream_count >= SEQ_MAX_STREAMS - 1) {
+        if (!tracker->full_warned) {
+            fprintf(stderr, "Warning: Sequence tracker full, new streams are not tracked\n");
+            tracker->full_warned = true;
+        }
+        return NULL;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+    snprintf(stream->symbol, sizeof(stream->symbol), "%s", symbol);
+    stream->type = type;
+    stream->in_use = true;
+    tracker->stream_count++;
+    return stream;
+}
+
+static void report(seq_tracker_t *tracker, seq_status_t status, const seq_stream_t *stream,
+                   long expected, long received, long missing) {
+    if (!tracker->on_event) {
+        return;
+    }
+
+    seq_event_t event;
+    event.status = status;
+    event.type = stream->type;
+    event.symbol = stream->symbol;
+    event.expected = expected;
+    event.received = received;
+    event.missing = missing;
+    event.stream = stream;
+    tracker->on_event(tracker->user, &event);
+}
+
+seq_status_t seq_tracker_check(seq_tracker_t *tracker, const market_data_t *data) {
+    if (!tracker || !data || !data->symbol) {
+        return SEQ_UNTRACKED;
+    }
+
+    // Map event ids onto first/last/previous ids of the message
+    seq_stream_type_t type;
+    long first_id, last_id, prev_id = 0;
+    bool contiguous;
+
+    switch (data->event) {
+        case MARKET_EVENT_AGG_TRADE:
+            type = SEQ_STREAM_AGG_TRADE;
+            first_id = last_id = data->agg_trade_id;
+            contiguous = true;
+            break;
+        case MARKET_EVENT_BOOK_TICKER:
+            // Book ticker ids are shared with the book, so only ordering is checked
+            type = SEQ_STREAM_BOOK_TICKER;
+            first_id = last_id = data->final_update_id;
+            contiguous = false;
+            break;
+        case MARKET_EVENT_DEPTH:
+            type = SEQ_STREAM_DEPTH;
+            first_id = data->first_update_id;
+            last_id = data->final_update_id;
+            prev_id = data->prev_final_update_id;
+            contiguous = true;
+            break;
+        default:
+            return SEQ_UNTRACKED;
+    }
+
+    seq_stream_t *stream = get_stream(tracker, data->symbol, type);
+    if (!stream) {
+        return SEQ_UNTRACKED;
+    }
+
+    stream->messages++;
+
+    if (!stream->has_last) {
+        stream->last_id = last_id;
+        stream->last_trade_id = type == SEQ_STREAM_AGG_TRADE ? data->last_trade_id : 0;
+        stream->has_last = true;
+        return SEQ_OK;
+    }
+
+    if (last_id == stream->last_id) {
+        stream->duplicates++;
+        report(tracker, SEQ_DUPLICATE, stream, stream->last_id, last_id, 0);
+        return SEQ_DUPLICATE;
+    }
+
+    if (last_id < stream->last_id) {
+        stream->reorders++;
+        report(tracker, SEQ_REORDER, stream, stream->last_id, last_id, 0);
+        return SEQ_REORDER;
+    }
+
+    seq_status_t status = SEQ_OK;
+    long expected = stream->last_id;
+    long previous_trade_id = stream->last_trade_id;
+    if (type == SEQ_STREAM_AGG_TRADE) {
+        stream->last_trade_id = data->last_trade_id;
+    }
+
+    if (contiguous) {
+        if (prev_id != 0) {
+            // Futures depth links each event to the previous final id
+            if (prev_id != stream->last_id) {
+                status = SEQ_GAP;
+                stream->gaps++;
+                report(tracker, SEQ_GAP, stream, expected, prev_id, 0);
+            }
+        } else if (first_id > stream->last_id + 1) {
+            long missing = first_id - stream->last_id - 1;
+            status = SEQ_GAP;
+            stream->gaps++;
+            stream->missing += (uint64_t)missing;
+            report(tracker, SEQ_GAP, stream, expected + 1, first_id, missing);
+        } else if (type == SEQ_STREAM_AGG_TRADE && previous_trade_id > 0 &&
+                   data->first_trade_id > 0 && data->first_trade_id != previous_trade_id + 1) {
+            // Consecutive aggregates must cover consecutive trades
+            long missing = data->first_trade_id - previous_trade_id - 1;
+            status = SEQ_TRADE_GAP;
+            stream->trade_gaps++;
+            if (missing > 0) {
+                stream->missing_trades += (uint64_t)missing;
+            }
+            report(tracker, SEQ_TRADE_GAP, stream, previous_trade_id + 1, data->first_trade_id,
+                   missing > 0 ? missing : 0);
+        }
+    }
+
+    stream->last_id = last_id;
+    return status;
+}
+
+const seq_stream_t* seq_tracker_find(const seq_tracker_t *tracker, const char *symbol,
+                                     seq_stream_type_t type) {
+    if (!tracker || !symbol) {
+        return NULL;
+    }
+
+    bool found;
+    const seq_stream_t *stream = lookup_stream(tracker, symbol, type, &found);
+    return found ? stream : NULL;
+}
+
+void seq_tracker_reset(seq_tracker_t *tracker, const char *symbol, seq_stream_type_t type) {
+    if (!tracker || !symbol) {
+        return;
+    }
+
+    bool found;
+    seq_stream_t *stream = lookup_stream(tracker, symbol, type, &found);
+    if (found) {
+        stream->has_last = false;
+    }
+}
+
+void seq_tracker_reset_all(seq_tracker_t *tracker) {
+    if (!tracker) {
+        return;
+    }
+
+    for (int i = 0; i < SEQ_MAX_STREAMS; i++) {
+        tracker->streams[i].has_last = false;
+    }
+}
+
+void seq_tracker_print(const seq_tracker_t *tracker) {
+    if (!tracker) {
+        return;
+    }
+
+    printf("\n=== Sequence Statistics ===\n");
+    int printed = 0;
+    for (int i = 0; i < SEQ_MAX_STREAMS; i++) {
+        const seq_stream_t *stream = &tracker->streams[i];
+        if (!stream->in_use) {
+            continue;
+        }
+        printf("%-12s %-12s msgs=%llu gaps=%llu missing=%llu dups=%llu reorders=%llu",
+               stream->symbol, seq_stream_type_name(stream->type),
+               (unsigned long long)stream->messages, (unsigned long long)stream->gaps,
+               (unsigned long long)stream->missing, (unsigned long long)stream->duplicates,
+               (unsigned long long)stream->reorders);
+        if (stream->type == SEQ_STREAM_AGG_TRADE) {
+            printf(" trade_gaps=%llu missing_trades=%llu",
+                   (unsigned long long)stream->trade_gaps,
+                   (unsigned long long)stream->missing_trades);
+        }
+        printf("\n");
+        printed++;
+    }
+    if (printed == 0) {
+        printf("No sequenced streams seen\n");
+    }
+    printf("===========================\n");
+}
+
+void seq_tracker_destroy(seq_tracker_t *tracker) {
+    free(tracker);
+}
\ No newline at end of file
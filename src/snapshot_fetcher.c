@@ -0,0 +1,314 @@
+#include "snapshot_fetcher.h"
+#include "frame_assembler.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_BACKOFF_NS (60LL * 1000000000LL)
+
+// One in-flight request, handed to lws as the connection's user data
+typedef struct snapshot_request {
+    snapshot_fetcher_t *fetcher;
+    struct lws *wsi;
+    char symbol[32];
+    frame_assembler_t body;
+    int status;
+    bool starting;    // inside lws_client_connect_via_info
+    bool done;        // on_done already called
+    bool cancelled;   // result no longer wanted
+    struct snapshot_request *prev;
+    struct snapshot_request *next;
+} snapshot_request_t;
+
+// Exchange weight of GET /fapi/v1/depth by limit
+static int depth_weight(int limit) {
+    if (limit <= 50) {
+        return 2;
+    }
+    if (limit <= 100) {
+        return 5;
+    }
+    if (limit <= 500) {
+        return 10;
+    }
+    return 20;
+}
+
+static void finish(snapshot_request_t *request, int status) {
+    if (request->done) {
+        return;
+    }
+    request->done = true;
+
+    snapshot_fetcher_t *fetcher = request->fetcher;
+    fetcher->in_flight--;
+    if (request->cancelled) {
+        return;
+    }
+
+    const char *body = "";
+    size_t len = 0;
+    if (status >= 0) {
+        frame_status_t complete = frame_assembler_push(&request->body, NULL, 0, false, true);
+        if (complete == FRAME_COMPLETE) {
+            body = request->body.buffer;
+            len = request->body.len;
+        }
+    }
+
+    if (status == 418 || status == 429) {
+        // Rate limited: stop starting requests for a while
+        fetcher->backoff_until_ns = metrics_clock_ns() + SNAPSHOT_BACKOFF_NS;
+        fprintf(stderr, "Snapshot requests rate limited (HTTP %d), backing off\n", status);
+    }
+
+    if (status == 200 && len > 0) {
+        metrics_inc(METRIC_SNAPSHOTS_FETCHED);
+    } else {
+        metrics_inc(METRIC_SNAPSHOT_FAILURES);
+    }
+
+    if (fetcher->on_done) {
+        fetcher->on_done(fetcher->ctx, request->symbol, status, body, len);
+    }
+}
+
+static void free_request(snapshot_request_t *request) {
+    if (request->prev) {
+        request->prev->next = request->next;
+    } else {
+        request->fetcher->requests = request->next;
+    }
+    if (request->next) {
+        request->next->prev = request->prev;
+    }
+    frame_assembler_free(&request->body);
+    free(request);
+}
+
+static int callback_snapshot(struct lws *wsi, enum lws_callback_reasons reason,
+                             void *user, void *in, size_t len) {
+    snapshot_request_t *request = (snapshot_request_t *)user;
+    
+    switch (reason) {
+        case LWS_CALLBACK_ESTABLISHED_CLIENT_HTTP:
+            if (request) {
+                if (request->cancelled) {
+                    return -1;
+                }
+                request->status = (int)lws_http_client_http_response(wsi);
+            }
+            break;
+            
+        case LWS_CALLBACK_RECEIVE_CLIENT_HTTP: {
+            if (request && request->cancelled) {
+                return -1;
+            }
+            // Body bytes are pending: have lws deliver them as RECEIVE_CLIENT_HTTP_READ
+            char buffer[LWS_PRE + 4096];
+            char *p = buffer + LWS_PRE;
+            int n = (int)sizeof(buffer) - LWS_PRE;
+            if (lws_http_client_read(wsi, &p, &n) < 0) {
+                return -1;
+            }
+            return 0;
+        }
+            
+        case LWS_CALLBACK_RECEIVE_CLIENT_HTTP_READ:
+            if (request && in && len > 0) {
+                frame_assembler_push(&request->body, in, len, false, false);
+            }
+            return 0;
+            
+        case LWS_CALLBACK_COMPLETED_CLIENT_HTTP:
+            if (request) {
+                finish(request, request->status);
+            }
+            break;
+            
+        case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+            if (!request) {
+                return 0;
+            }
+            fprintf(stderr, "Snapshot request for %s failed: %s\n", request->symbol,
+                    in ? (const char *)in : "connection error");
+            finish(request, -1);
+            // While still inside the connect call, the caller frees it
+            if (!request->starting) {
+                free_request(request);
+                // lws may still report the close of this connection
+                lws_set_wsi_user(wsi, NULL);
+            }
+            return 0;
+            
+        case LWS_CALLBACK_CLOSED_CLIENT_HTTP:
+            if (!request) {
+                return 0;
+            }
+            finish(request, -1);
+            free_request(request);
+            lws_set_wsi_user(wsi, NULL);
+            return 0;
+            
+        default:
+            break;
+    }
+    
+    return lws_callback_http_dummy(wsi, reason, user, in, len);
+}
+
+static const struct lws_protocols snapshot_protocols[] = {
+    {
+        "depth-snapshot",
+        callback_snapshot,
+        0,
+        0,
+    },
+    { NULL, NULL, 0, 0 }
+};
+
+snapshot_fetcher_t* snapshot_fetcher_create(struct lws_context *context, const char *host, int port,
+                                            bool tls, int limit, int max_in_flight,
+                                            int weight_per_minute, snapshot_done_fn on_done,
+                                            void *ctx) {
+    if (!context || !host) {
+        return NULL;
+    }
+
+    snapshot_fetcher_t *fetcher = (snapshot_fetcher_t *)calloc(1, sizeof(snapshot_fetcher_t));
+    if (!fetcher) {
+        return NULL;
+    }
+
+    struct lws_context_creation_info info;
+    memset(&info, 0, sizeof(info));
+    info.port = CONTEXT_PORT_NO_LISTEN;
+    info.protocols = snapshot_protocols;
+    info.vhost_name = "rest";
+    info.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT;
+
+    fetcher->vhost = lws_create_vhost(context, &info);
+    if (!fetcher->vhost) {
+        fprintf(stderr, "Failed to create REST vhost\n");
+        free(fetcher);
+        return NULL;
+    }
+
+    fetcher->context = context;
+    fetcher->host = strdup(host);
+    fetcher->port = port;
+    fetcher->tls = tls;
+    fetcher->limit = limit > 0 ? limit : 1000;
+    fetcher->weight = depth_weight(fetcher->limit);
+    fetcher->max_in_flight = max_in_flight > 0 ? max_in_flight : 1;
+    fetcher->weight_per_minute = weight_per_minute > 0 ? weight_per_minute : 2400;
+    fetcher->tokens = fetcher->weight_per_minute;
+    fetcher->refilled_ns = metrics_clock_ns();
+    fetcher->on_done = on_done;
+    fetcher->ctx = ctx;
+    return fetcher;
+}
+
+static void refill(snapshot_fetcher_t *fetcher, int64_t now_ns) {
+    double elapsed = (double)(now_ns - fetcher->refilled_ns) / 60e9;
+    if (elapsed <= 0.0) {
+        return;
+    }
+    fetcher->tokens += elapsed * fetcher->weight_per_minute;
+    if (fetcher->tokens > fetcher->weight_per_minute) {
+        fetcher->tokens = fetcher->weight_per_minute;
+    }
+    fetcher->refilled_ns = now_ns;
+}
+
+bool snapshot_fetcher_ready(snapshot_fetcher_t *fetcher, int64_t now_ns) {
+    if (!fetcher || fetcher->in_flight >= fetcher->max_in_flight ||
+        now_ns < fetcher->backoff_until_ns) {
+        return false;
+    }
+    refill(fetcher, now_ns);
+    return fetcher->tokens >= fetcher->weight;
+}
+
+int snapshot_fetcher_start(snapshot_fetcher_t *fetcher, const char *symbol, int64_t now_ns) {
+    if (!snapshot_fetcher_ready(fetcher, now_ns) || !symbol) {
+        return -1;
+    }
+
+    snapshot_request_t *request = (snapshot_request_t *)calloc(1, sizeof(snapshot_request_t));
+    if (!request) {
+        return -1;
+    }
+    request->fetcher = fetcher;
+    snprintf(request->symbol, sizeof(request->symbol), "%s", symbol);
+    frame_assembler_init(&request->body, SNAPSHOT_MAX_BODY);
+    request->next = fetcher->requests;
+    if (fetcher->requests) {
+        fetcher->requests->prev = request;
+    }
+    fetcher->requests = request;
+
+    char path[128];
+    snprintf(path, sizeof(path), "/fapi/v1/depth?symbol=%s&limit=%d", request->symbol, fetcher->limit);
+
+    struct lws_client_connect_info ccinfo;
+    memset(&ccinfo, 0, sizeof(ccinfo));
+    ccinfo.context = fetcher->context;
+    ccinfo.vhost = fetcher->vhost;
+    ccinfo.address = fetcher->host;
+    ccinfo.port = fetcher->port;
+    ccinfo.path = path;
+    ccinfo.host = fetcher->host;
+    ccinfo.origin = fetcher->host;
+    ccinfo.method = "GET";
+    ccinfo.alpn = "http/1.1";
+    ccinfo.ssl_connection = fetcher->tls ? LCCSCF_USE_SSL : 0;
+    ccinfo.local_protocol_name = snapshot_protocols[0].name;
+    ccinfo.userdata = request;
+    ccinfo.pwsi = &request->wsi;
+
+    fetcher->tokens -= fetcher->weight;
+    fetcher->in_flight++;
+
+    // Connection errors may be reported from inside this call; either way the
+    // outcome reaches on_done exactly once
+    request->starting = true;
+    struct lws *wsi = lws_client_connect_via_info(&ccinfo);
+    request->starting = false;
+    if (!wsi || request->done) {
+        if (wsi) {
+            lws_set_wsi_user(wsi, NULL);
+        }
+        finish(request, -1);
+        free_request(request);
+    }
+    return 0;
+}
+
+void snapshot_fetcher_cancel(snapshot_fetcher_t *fetcher, const char *symbol) {
+    if (!fetcher || !symbol) {
+        return;
+    }
+
+    for (snapshot_request_t *request = fetcher->requests; request; request = request->next) {
+        if (request->done || request->cancelled || strcmp(request->symbol, symbol) != 0) {
+            continue;
+        }
+        // Still counted in flight until the connection is gone
+        request->cancelled = true;
+        if (request->wsi) {
+            lws_set_timeout(request->wsi, PENDING_TIMEOUT_KILLED_BY_PARENT, LWS_TO_KILL_ASYNC);
+        }
+    }
+}
+
+void snapshot_fetcher_destroy(snapshot_fetcher_t *fetcher) {
+    if (!fetcher) {
+        return;
+    }
+
+    // The vhost goes away with the context
+    free(fetcher->host);
+    free(fetcher);
+}
\ No newline at end of file
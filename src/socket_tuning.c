@@ -0,0 +1,219 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "socket_tuning.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+#include <openssl/bio.h>
+#ifdef __linux__
+#include <sched.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#endif
+
+static int set_int_option(int fd, int level, int name, int value, const char *label) {
+    if (setsockopt(fd, level, name, &value, sizeof(value)) < 0) {
+        fprintf(stderr, "Warning: Failed to set %s: %s\n", label, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int socket_tuning_apply(int fd, const socket_tuning_t *tuning) {
+    if (fd < 0 || !tuning) {
+        return -1;
+    }
+
+    int result = 0;
+
+    if (tuning->rcvbuf > 0) {
+        result |= set_int_option(fd, SOL_SOCKET, SO_RCVBUF, tuning->rcvbuf, "SO_RCVBUF");
+    }
+
+    if (tuning->tcp_nodelay) {
+        result |= set_int_option(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    }
+
+#ifdef SO_BUSY_POLL
+    if (tuning->busy_poll_us > 0) {
+        result |= set_int_option(fd, SOL_SOCKET, SO_BUSY_POLL, tuning->busy_poll_us, "SO_BUSY_POLL");
+    }
+#endif
+
+#ifdef TCP_QUICKACK
+    if (tuning->tcp_quickack) {
+        result |= set_int_option(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+    }
+#endif
+
+#ifdef SO_TIMESTAMPING
+    if (tuning->rx_timestamping) {
+        int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                    SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        result |= set_int_option(fd, SOL_SOCKET, SO_TIMESTAMPING, flags, "SO_TIMESTAMPING");
+    }
+#endif
+
+    return result;
+}
+
+void socket_tuning_rearm(int fd, const socket_tuning_t *tuning) {
+#ifdef TCP_QUICKACK
+    if (fd >= 0 && tuning && tuning->tcp_quickack) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+    }
+#else
+    (void)fd;
+    (void)tuning;
+#endif
+}
+
+int64_t socket_tuning_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#ifdef SO_TIMESTAMPING
+// Read BIO that uses recvmsg and keeps the kernel timestamp of the last read
+typedef struct {
+    int fd;
+    int64_t *stamp_ns;
+} rx_stamp_bio_t;
+
+static BIO_METHOD *rx_stamp_method = NULL;
+
+static int rx_stamp_read(BIO *bio, char *out, int outl) {
+    rx_stamp_bio_t *ctx = (rx_stamp_bio_t *)BIO_get_data(bio);
+    if (!ctx || !out || outl <= 0) {
+        return 0;
+    }
+
+    char control[CMSG_SPACE(sizeof(struct scm_timestamping))];
+    struct iovec iov = { out, (size_t)outl };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    BIO_clear_retry_flags(bio);
+    ssize_t n = recvmsg(ctx->fd, &msg, 0);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            BIO_set_retry_read(bio);
+        }
+        return -1;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMPING) {
+            continue;
+        }
+        const struct scm_timestamping *ts = (const struct scm_timestamping *)CMSG_DATA(cmsg);
+        // Prefer the raw hardware stamp, fall back to software
+        const struct timespec *t = (ts->ts[2].tv_sec || ts->ts[2].tv_nsec) ? &ts->ts[2] : &ts->ts[0];
+        if (t->tv_sec || t->tv_nsec) {
+            *ctx->stamp_ns = (int64_t)t->tv_sec * 1000000000LL + t->tv_nsec;
+        }
+    }
+
+    return (int)n;
+}
+
+static long rx_stamp_ctrl(BIO *bio, int cmd, long num, void *ptr) {
+    (void)num;
+    rx_stamp_bio_t *ctx = (rx_stamp_bio_t *)BIO_get_data(bio);
+
+    switch (cmd) {
+        case BIO_C_GET_FD:
+            if (ptr) {
+                *(int *)ptr = ctx ? ctx->fd : -1;
+            }
+            return ctx ? ctx->fd : -1;
+        case BIO_CTRL_FLUSH:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int rx_stamp_destroy(BIO *bio) {
+    free(BIO_get_data(bio));
+    BIO_set_data(bio, NULL);
+    return 1;
+}
+
+int socket_tuning_attach_rx_timestamps(void *ssl, int fd, int64_t *stamp_ns) {
+    if (!ssl || fd < 0 || !stamp_ns) {
+        return -1;
+    }
+
+    if (!rx_stamp_method) {
+        rx_stamp_method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "rx-timestamp");
+        if (!rx_stamp_method) {
+            return -1;
+        }
+        BIO_meth_set_read(rx_stamp_method, rx_stamp_read);
+        BIO_meth_set_ctrl(rx_stamp_method, rx_stamp_ctrl);
+        BIO_meth_set_destroy(rx_stamp_method, rx_stamp_destroy);
+    }
+
+    rx_stamp_bio_t *ctx = (rx_stamp_bio_t *)calloc(1, sizeof(rx_stamp_bio_t));
+    if (!ctx) {
+        return -1;
+    }
+    ctx->fd = fd;
+    ctx->stamp_ns = stamp_ns;
+
+    BIO *bio = BIO_new(rx_stamp_method);
+    if (!bio) {
+        free(ctx);
+        return -1;
+    }
+    BIO_set_data(bio, ctx);
+    BIO_set_init(bio, 1);
+
+    // Socket BIOs hold no buffered data, so swapping after the handshake is safe
+    SSL_set0_rbio((SSL *)ssl, bio);
+    return 0;
+}
+#else
+int socket_tuning_attach_rx_timestamps(void *ssl, int fd, int64_t *stamp_ns) {
+    (void)ssl;
+    (void)fd;
+    (void)stamp_ns;
+    return -1;
+}
+#endif
+
+int socket_tuning_set_thread_cpu(int cpu) {
+    if (cpu < 0) {
+        return 0;
+    }
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        fprintf(stderr, "Warning: Failed to pin thread to CPU %d: %s\n", cpu, strerror(err));
+        return -1;
+    }
+    return 0;
+#else
+    fprintf(stderr, "Warning: CPU affinity not supported on this platform\n");
+    return -1;
+#endif
+}
\ No newline at end of file
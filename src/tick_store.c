@@ -0,0 +1,547 @@
+#include "tick_store.h"
+#include "symbol_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SEGMENT_MAGIC 0x4b434954u  // "TICK"
+#define SEGMENT_VERSION 1
+#define COLUMN_INITIAL_SIZE 65536
+#define PRICE_SCALE 1e8
+#define MS_PER_DAY 86400000LL
+#define MAX_VARINT_BYTES 10
+
+// Column files of a segment
+enum {
+    COL_TS = 0,   // zigzag varint timestamp deltas
+    COL_PX,       // zigzag varint fixed point price deltas
+    COL_QTY,      // zigzag varint fixed point quantities
+    COL_SIDE,     // one byte per row
+    COL_IDX,      // segment header followed by block index
+    COL_COUNT
+};
+
+static const char *column_names[COL_COUNT] = { "ts", "px", "qty", "side", "idx" };
+static const char *kind_names[TICK_KINDS] = { "trade", "quote" };
+
+// Delta bases and byte offsets at the start of each block of rows
+typedef struct {
+    int64_t first_ts;
+    int64_t base_ts;
+    int64_t base_px;
+    uint64_t row;
+    uint64_t offset[COL_SIDE];
+} segment_block_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t rows;
+    uint64_t bytes[COL_SIDE];
+    int64_t last_ts;
+    int64_t last_px;
+    uint64_t block_count;
+} segment_header_t;
+
+typedef struct {
+    int fd;
+    uint8_t *data;
+    size_t capacity;
+} tick_column_t;
+
+struct tick_segment {
+    char symbol[TICK_STORE_SYMBOL_SIZE];
+    tick_kind_t kind;
+    int64_t day;
+    bool writable;
+    tick_column_t cols[COL_COUNT];
+};
+
+static segment_header_t* segment_header(const tick_segment_t *seg) {
+    return (segment_header_t *)seg->cols[COL_IDX].data;
+}
+
+static segment_block_t* segment_blocks(const tick_segment_t *seg) {
+    return (segment_block_t *)(seg->cols[COL_IDX].data + sizeof(segment_header_t));
+}
+
+static inline uint64_t zigzag_encode(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline size_t varint_write(uint8_t *out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint64_t varint_read(const uint8_t **p) {
+    const uint8_t *q = *p;
+    uint64_t v = *q & 0x7f;
+    int shift = 7;
+    while (*q++ & 0x80) {
+        v |= (uint64_t)(*q & 0x7f) << shift;
+        shift += 7;
+    }
+    *p = q;
+    return v;
+}
+
+static int64_t to_fixed(double value) {
+    return llround(value * PRICE_SCALE);
+}
+
+static int mkdir_p(const char *path) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "%s", path);
+
+    for (char *p = buf + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(buf, 0755) < 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(buf, 0755) < 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+// Segment directory for a symbol and UTC day, e.g. root/BTCUSDT/20240131
+static void segment_dir(char *out, size_t size, const char *root, const char *symbol, int64_t day) {
+    time_t secs = (time_t)(day * (MS_PER_DAY / 1000));
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    snprintf(out, size, "%s/%s/%04d%02d%02d", root, symbol,
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
+static int column_map(tick_column_t *col, size_t size, bool writable) {
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *p = mmap(NULL, size, prot, MAP_SHARED, col->fd, 0);
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    if (col->data) {
+        munmap(col->data, col->capacity);
+    }
+    col->data = (uint8_t *)p;
+    col->capacity = size;
+    return 0;
+}
+
+// Grow column file and mapping so that at least needed bytes are addressable
+static int column_reserve(tick_column_t *col, size_t needed) {
+    if (needed <= col->capacity) {
+        return 0;
+    }
+
+    size_t capacity = col->capacity ? col->capacity : COLUMN_INITIAL_SIZE;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    if (ftruncate(col->fd, (off_t)capacity) < 0) {
+        return -1;
+    }
+    return column_map(col, capacity, true);
+}
+
+static void segment_free(tick_segment_t *seg) {
+    if (!seg) {
+        return;
+    }
+    for (int i = 0; i < COL_COUNT; i++) {
+        if (seg->cols[i].data) {
+            munmap(seg->cols[i].data, seg->cols[i].capacity);
+        }
+        if (seg->cols[i].fd >= 0) {
+            close(seg->cols[i].fd);
+        }
+    }
+    free(seg);
+}
+
+static tick_segment_t* segment_open(const char *root, const char *symbol, tick_kind_t kind,
+                                    int64_t day, bool writable) {
+    char dir[1024];
+    segment_dir(dir, sizeof(dir), root, symbol, day);
+    if (writable && mkdir_p(dir) < 0) {
+        fprintf(stderr, "Failed to create segment directory %s: %s\n", dir, strerror(errno));
+        return NULL;
+    }
+
+    tick_segment_t *seg = (tick_segment_t *)calloc(1, sizeof(tick_segment_t));
+    if (!seg) {
+        return NULL;
+    }
+    snprintf(seg->symbol, sizeof(seg->symbol), "%s", symbol);
+    seg->kind = kind;
+    seg->day = day;
+    seg->writable = writable;
+    for (int i = 0; i < COL_COUNT; i++) {
+        seg->cols[i].fd = -1;
+    }
+
+    for (int i = 0; i < COL_COUNT; i++) {
+        char path[1100];
+        snprintf(path, sizeof(path), "%s/%s.%s", dir, kind_names[kind], column_names[i]);
+
+        tick_column_t *col = &seg->cols[i];
+        col->fd = writable ? open(path, O_RDWR | O_CREAT, 0644) : open(path, O_RDONLY);
+        if (col->fd < 0) {
+            if (writable) {
+                fprintf(stderr, "Failed to open segment column %s: %s\n", path, strerror(errno));
+            }
+            segment_free(seg);
+            return NULL;
+        }
+
+        struct stat st;
+        if (fstat(col->fd, &st) < 0) {
+            segment_free(seg);
+            return NULL;
+        }
+        if (st.st_size > 0 && column_map(col, (size_t)st.st_size, writable) < 0) {
+            segment_free(seg);
+            return NULL;
+        }
+    }
+
+    // New segment: write header
+    if (seg->cols[COL_IDX].capacity < sizeof(segment_header_t)) {
+        if (!writable || column_reserve(&seg->cols[COL_IDX], sizeof(segment_header_t)) < 0) {
+            segment_free(seg);
+            return NULL;
+        }
+        segment_header_t *header = segment_header(seg);
+        memset(header, 0, sizeof(*header));
+        header->magic = SEGMENT_MAGIC;
+        header->version = SEGMENT_VERSION;
+    }
+
+    segment_header_t *header = segment_header(seg);
+    if (header->magic != SEGMENT_MAGIC || header->version != SEGMENT_VERSION) {
+        fprintf(stderr, "Invalid segment header in %s\n", dir);
+        segment_free(seg);
+        return NULL;
+    }
+
+    return seg;
+}
+
+static int segment_append(tick_segment_t *seg, const tick_t *tick) {
+    segment_header_t *header = segment_header(seg);
+    uint64_t row = header->rows;
+    int64_t px = to_fixed(tick->price);
+    int64_t qty = to_fixed(tick->quantity);
+
+    // Start a new index block every TICK_STORE_BLOCK_ROWS rows
+    if (row % TICK_STORE_BLOCK_ROWS == 0) {
+        size_t needed = sizeof(segment_header_t) + (header->block_count + 1) * sizeof(segment_block_t);
+        if (column_reserve(&seg->cols[COL_IDX], needed) < 0) {
+            return -1;
+        }
+        header = segment_header(seg);
+
+        segment_block_t *block = &segment_blocks(seg)[header->block_count];
+        block->first_ts = tick->timestamp;
+        block->base_ts = header->last_ts;
+        block->base_px = header->last_px;
+        block->row = row;
+        for (int i = 0; i < COL_SIDE; i++) {
+            block->offset[i] = header->bytes[i];
+        }
+        header->block_count++;
+    }
+
+    uint64_t values[COL_SIDE] = {
+        zigzag_encode(tick->timestamp - header->last_ts),
+        zigzag_encode(px - header->last_px),
+        zigzag_encode(qty),
+    };
+
+    for (int i = 0; i < COL_SIDE; i++) {
+        if (column_reserve(&seg->cols[i], header->bytes[i] + MAX_VARINT_BYTES) < 0) {
+            return -1;
+        }
+        header->bytes[i] += varint_write(seg->cols[i].data + header->bytes[i], values[i]);
+    }
+
+    if (column_reserve(&seg->cols[COL_SIDE], row + 1) < 0) {
+        return -1;
+    }
+    seg->cols[COL_SIDE].data[row] = (uint8_t)tick->side;
+
+    header->last_ts = tick->timestamp;
+    header->last_px = px;
+    header->rows = row + 1;
+    return 0;
+}
+
+tick_store_t* tick_store_open(const char *root_dir) {
+    if (!root_dir || mkdir_p(root_dir) < 0) {
+        fprintf(stderr, "Failed to create tick store directory %s\n", root_dir ? root_dir : "(null)");
+        return NULL;
+    }
+
+    tick_store_t *store = (tick_store_t *)calloc(1, sizeof(tick_store_t));
+    if (!store) {
+        return NULL;
+    }
+
+    store->root_dir = strdup(root_dir);
+    printf("Tick store opened at %s\n", root_dir);
+    return store;
+}
+
+// Flush a writable segment's mappings, MS_SYNC waits for the data to reach disk
+static int segment_sync(const tick_segment_t *seg, int flags) {
+    int result = 0;
+    for (int i = 0; i < COL_COUNT; i++) {
+        if (seg->cols[i].data && msync(seg->cols[i].data, seg->cols[i].capacity, flags) < 0) {
+            fprintf(stderr, "Failed to sync %s %s column: %s\n", seg->symbol, column_names[i],
+                    strerror(errno));
+            result = -1;
+        }
+    }
+    return result;
+}
+
+// Find the slot holding the symbol's open segment, or the empty slot for it
+static tick_segment_t** segment_slot(tick_store_t *store, const char *symbol, tick_kind_t kind) {
+    unsigned int slot = symbol_hash(symbol, (unsigned int)kind) & (TICK_STORE_MAX_SEGMENTS - 1);
+
+    for (int probe = 0; probe < TICK_STORE_MAX_SEGMENTS; probe++) {
+        tick_segment_t *seg = store->segments[slot];
+        if (!seg || (seg->kind == kind && strcmp(seg->symbol, symbol) == 0)) {
+            return &store->segments[slot];
+        }
+        slot = (slot + 1) & (TICK_STORE_MAX_SEGMENTS - 1);
+    }
+    return NULL;
+}
+
+int tick_store_append(tick_store_t *store, const char *symbol, tick_kind_t kind, const tick_t *tick) {
+    if (!store || !symbol || !tick || kind >= TICK_KINDS) {
+        return -1;
+    }
+
+    int64_t day = tick->timestamp / MS_PER_DAY;
+    tick_segment_t **slot = segment_slot(store, symbol, kind);
+    if (!slot) {
+        return -1;
+    }
+
+    tick_segment_t *seg = *slot;
+    if (seg && seg->day != day) {
+        // Day rolled over, continue in a fresh segment
+        tick_segment_t *next = segment_open(store->root_dir, symbol, kind, day, true);
+        if (!next) {
+            return -1;
+        }
+        // Start writeback of the finished day without blocking the append path
+        segment_sync(seg, MS_ASYNC);
+        segment_free(seg);
+        *slot = seg = next;
+    }
+
+    if (!seg) {
+        // Keep one slot free so probing always terminates
+        if (store->segment_count >= TICK_STORE_MAX_SEGMENTS - 1) {
+            if (!store->full_warned) {
+                fprintf(stderr, "Warning: Tick store segment table full\n");
+                store->full_warned = true;
+            }
+            return -1;
+        }
+        seg = segment_open(store->root_dir, symbol, kind, day, true);
+        if (!seg) {
+            return -1;
+        }
+        *slot = seg;
+        store->segment_count++;
+    }
+
+    return segment_append(seg, tick);
+}
+
+int tick_store_append_market_data(tick_store_t *store, const market_data_t *data) {
+    if (!data || !data->symbol) {
+        return -1;
+    }
+
+    if (data->event == MARKET_EVENT_AGG_TRADE) {
+        tick_t tick;
+        tick.timestamp = data->timestamp;
+        tick.price = data->price;
+        tick.quantity = data->quantity;
+        // Buyer is maker means the seller crossed the spread
+        tick.side = data->is_buyer_maker ? TICK_SIDE_SELL : TICK_SIDE_BUY;
+        return tick_store_append(store, data->symbol, TICK_KIND_TRADE, &tick);
+    }
+
+    if (data->event == MARKET_EVENT_BOOK_TICKER && data->bid_count > 0 && data->ask_count > 0 &&
+        data->bid_quantities && data->ask_quantities) {
+        tick_t bid = { data->timestamp, data->bid_prices[0], data->bid_quantities[0], TICK_SIDE_BID };
+        tick_t ask = { data->timestamp, data->ask_prices[0], data->ask_quantities[0], TICK_SIDE_ASK };
+        if (tick_store_append(store, data->symbol, TICK_KIND_QUOTE, &bid) < 0) {
+            return -1;
+        }
+        return tick_store_append(store, data->symbol, TICK_KIND_QUOTE, &ask);
+    }
+
+    return 0;
+}
+
+// Decode rows of one segment, starting at the last block that begins before t0.
+// Rows equal to t0 may end the previous block, so a block starting at t0 is not enough.
+static int64_t segment_scan(const tick_segment_t *seg, int64_t t0, int64_t t1,
+                            void (*on_batch)(const tick_batch_t *batch, void *ctx), void *ctx,
+                            tick_batch_t *batch) {
+    // Snapshot the header, a writer may be appending concurrently
+    segment_header_t header = *segment_header(seg);
+    if (header.rows == 0 || header.block_count == 0) {
+        return 0;
+    }
+
+    // Only decode what our mappings cover
+    size_t index_bytes = sizeof(segment_header_t) + header.block_count * sizeof(segment_block_t);
+    if (index_bytes > seg->cols[COL_IDX].capacity || header.rows > seg->cols[COL_SIDE].capacity) {
+        return 0;
+    }
+    for (int i = 0; i < COL_SIDE; i++) {
+        if (header.bytes[i] > seg->cols[i].capacity) {
+            return 0;
+        }
+    }
+
+    const segment_block_t *blocks = segment_blocks(seg);
+
+    // Binary search the time index
+    uint64_t lo = 0, hi = header.block_count;
+    while (hi - lo > 1) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (blocks[mid].first_ts < t0) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    const segment_block_t *block = &blocks[lo];
+    const uint8_t *ts_p = seg->cols[COL_TS].data + block->offset[COL_TS];
+    const uint8_t *px_p = seg->cols[COL_PX].data + block->offset[COL_PX];
+    const uint8_t *qty_p = seg->cols[COL_QTY].data + block->offset[COL_QTY];
+    const uint8_t *side_p = seg->cols[COL_SIDE].data;
+    int64_t ts = block->base_ts;
+    int64_t px = block->base_px;
+    int64_t delivered = 0;
+
+    // Rows are appended in time order, so the scan stops at the first row past t1
+    for (uint64_t row = block->row; row < header.rows; row++) {
+        ts += zigzag_decode(varint_read(&ts_p));
+        px += zigzag_decode(varint_read(&px_p));
+        int64_t qty = zigzag_decode(varint_read(&qty_p));
+
+        if (ts > t1) {
+            break;
+        }
+        if (ts < t0) {
+            continue;
+        }
+
+        size_t i = batch->count++;
+        batch->timestamp[i] = ts;
+        batch->price[i] = (double)px / PRICE_SCALE;
+        batch->quantity[i] = (double)qty / PRICE_SCALE;
+        batch->side[i] = side_p[row];
+        delivered++;
+
+        if (batch->count == TICK_STORE_BLOCK_ROWS) {
+            on_batch(batch, ctx);
+            batch->count = 0;
+        }
+    }
+
+    return delivered;
+}
+
+int64_t tick_store_query(const char *root_dir, const char *symbol, tick_kind_t kind,
+                         int64_t t0, int64_t t1,
+                         void (*on_batch)(const tick_batch_t *batch, void *ctx), void *ctx) {
+    if (!root_dir || !symbol || !on_batch || kind >= TICK_KINDS || t1 < t0) {
+        return -1;
+    }
+
+    tick_batch_t *batch = (tick_batch_t *)malloc(sizeof(tick_batch_t));
+    if (!batch) {
+        return -1;
+    }
+    batch->count = 0;
+
+    int64_t delivered = 0;
+    for (int64_t day = t0 / MS_PER_DAY; day <= t1 / MS_PER_DAY; day++) {
+        tick_segment_t *seg = segment_open(root_dir, symbol, kind, day, false);
+        if (!seg) {
+            continue;  // no data that day
+        }
+        delivered += segment_scan(seg, t0, t1, on_batch, ctx, batch);
+        segment_free(seg);
+    }
+
+    if (batch->count > 0) {
+        on_batch(batch, ctx);
+    }
+
+    free(batch);
+    return delivered;
+}
+
+int tick_store_sync(tick_store_t *store) {
+    if (!store) {
+        return -1;
+    }
+
+    int result = 0;
+    for (int i = 0; i < TICK_STORE_MAX_SEGMENTS; i++) {
+        if (store->segments[i] && segment_sync(store->segments[i], MS_ASYNC) < 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+void tick_store_close(tick_store_t *store) {
+    if (!store) {
+        return;
+    }
+
+    for (int i = 0; i < TICK_STORE_MAX_SEGMENTS; i++) {
+        if (store->segments[i]) {
+            segment_sync(store->segments[i], MS_SYNC);
+            segment_free(store->segments[i]);
+        }
+    }
+
+    free(store->root_dir);
+    free(store);
+}
\ No newline at end of file
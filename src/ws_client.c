@@ -1,60 +1,168 @@
 #include "ws_client.h"
+#include "subscription.h"
+#include "metrics.h"
+#include "metrics_http.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <stdarg.h>
 
-static int callback_binance(struct lws *wsi, enum lws_callback_reasons reason,
+// Client being serviced on this thread, sends from its callbacks need no wakeup
+static _Thread_local ws_client_t *serviced_client = NULL;
+
+static void apply_established_tuning(ws_client_t *client, struct lws *wsi) {
+    int fd = lws_get_socket_fd(wsi);
+    
+    // Re-apply in case the connecting hook did not run for this socket
+    socket_tuning_apply(fd, &client->socket_tuning);
+    
+    client->kernel_rx_ns = 0;
+    if (client->socket_tuning.rx_timestamping) {
+#if defined(LWS_WITH_TLS) && !defined(LWS_WITH_MBEDTLS)
+        if (socket_tuning_attach_rx_timestamps(lws_get_ssl(wsi), fd, &client->kernel_rx_ns) == 0) {
+            ws_client_log(client, "Kernel receive timestamps enabled");
+            return;
+        }
+#endif
+        fprintf(stderr, "Warning: Kernel receive timestamps unavailable, using user space clock\n");
+    }
+}
+
+static int open_connection(ws_client_t *client);
+
+// Next attempt after the current delay, which doubles for the one after
+static void schedule_reconnect(ws_client_t *client) {
+    client->wsi = NULL;
+    if (client->reconnect_initial_ms <= 0 || !client->running) {
+        return;
+    }
+
+    client->reconnect_at_ns = metrics_clock_ns() + (int64_t)client->reconnect_delay_ms * 1000000;
+    ws_client_log(client, "Reconnecting in %d ms", client->reconnect_delay_ms);
+    client->reconnect_delay_ms *= 2;
+    if (client->reconnect_delay_ms > client->reconnect_max_ms) {
+        client->reconnect_delay_ms = client->reconnect_max_ms;
+    }
+}
+
+static int handle_callback(struct lws *wsi, enum lws_callback_reasons reason,
                            void *user, void *in, size_t len) {
     ws_client_t *client = (ws_client_t *)user;
+    if (!client && wsi) {
+        client = (ws_client_t *)lws_context_user(lws_get_context(wsi));
+    }
+    if (!client) {
+        return 0;
+    }
     
     switch (reason) {
+        case LWS_CALLBACK_CONNECTING:
+            // Socket exists but is not connected yet, set buffer sizes early
+            socket_tuning_apply(lws_get_socket_fd(wsi), &client->socket_tuning);
+            break;
+            
         case LWS_CALLBACK_CLIENT_ESTABLISHED:
-            printf("WebSocket connection established\n");
+            ws_client_log(client, "WebSocket connection established");
             client->connected = true;
+            client->reconnect_delay_ms = client->reconnect_initial_ms;
+            client->reconnect_attempts = 0;
+            metrics_inc(METRIC_CONNECTS);
+            apply_established_tuning(client, wsi);
             if (client->on_connect) {
-                client->on_connect();
+                client->on_connect(client->user);
             }
             lws_callback_on_writable(wsi);
             break;
             
-        case LWS_CALLBACK_CLIENT_RECEIVE:
-            if (in && len > 0) {
-                char *msg = (char *)malloc(len + 1);
-                memcpy(msg, in, len);
-                msg[len] = '\0';
-                
+        case LWS_CALLBACK_CLIENT_RECEIVE: {
+            bool first = lws_is_first_fragment(wsi);
+            if (first) {
+                // Stamp the message when its first bytes arrive
+                client->rx_timestamp_ns = client->kernel_rx_ns ? client->kernel_rx_ns
+                                                               : socket_tuning_now_ns();
+            }
+            socket_tuning_rearm(lws_get_socket_fd(wsi), &client->socket_tuning);
+            
+            // Large messages arrive over several callbacks, deliver them whole
+            frame_status_t status = frame_assembler_push(&client->rx_frame, in, in ? len : 0,
+                                                         first, lws_is_final_fragment(wsi));
+            if (status == FRAME_COMPLETE && client->rx_frame.len > 0) {
+                metrics_inc(METRIC_MESSAGES_RECEIVED);
+                metrics_add(METRIC_BYTES_RECEIVED, client->rx_frame.len);
                 if (client->on_message) {
-                    client->on_message(msg, len);
+                    client->on_message(client->user, client->rx_frame.buffer, client->rx_frame.len);
                 }
-                free(msg);
+            } else if (status == FRAME_DROPPED) {
+                metrics_inc(METRIC_FRAMES_DROPPED);
             }
             break;
+        }
             
-        case LWS_CALLBACK_CLIENT_WRITEABLE:
-            // Handle pending subscriptions
+        case LWS_CALLBACK_CLIENT_WRITEABLE: {
+            size_t out_len;
+            unsigned char *out = send_queue_peek(client->send_queue, &out_len);
+            if (!out) {
+                break;
+            }
+            
+            // lws keeps any unsent tail itself and holds off WRITEABLE until it is flushed
+            int n = lws_write(wsi, out, out_len, LWS_WRITE_TEXT);
+            send_queue_pop(client->send_queue);
+            if (n < 0) {
+                fprintf(stderr, "Failed to send message\n");
+                return -1;
+            }
+            metrics_inc(METRIC_MESSAGES_SENT);
+            metrics_add(METRIC_BYTES_SENT, out_len);
+            
+            // One write per callback, ask again while messages remain
+            if (send_queue_peek(client->send_queue, NULL)) {
+                lws_callback_on_writable(wsi);
+            }
+            break;
+        }
+            
+        case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+            // Another thread queued a message and woke the service loop
+            if (client->connected && client->wsi && send_queue_peek(client->send_queue, NULL)) {
+                lws_callback_on_writable(client->wsi);
+            }
             break;
             
         case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+            metrics_inc(METRIC_CONNECTION_ERRORS);
             if (in && len > 0) {
                 char *error = (char *)malloc(len + 1);
                 memcpy(error, in, len);
                 error[len] = '\0';
-                printf("Connection error: %s\n", error);
+                ws_client_log(client, "Connection error: %s", error);
                 if (client->on_error) {
-                    client->on_error(error);
+                    client->on_error(client->user, error);
                 }
                 free(error);
             }
             client->connected = false;
+            schedule_reconnect(client);
             break;
             
         case LWS_CALLBACK_CLIENT_CLOSED:
-            printf("WebSocket connection closed\n");
+            ws_client_log(client, "WebSocket connection closed");
             client->connected = false;
+            metrics_inc(METRIC_DISCONNECTS);
+            frame_assembler_reset(&client->rx_frame);
+            // Queued requests refer to the old session; on_connect of the next one
+            // subscribes again
+            send_queue_clear(client->send_queue);
+            // Server side subscriptions die with the connection
+            for (int i = 0; i < client->subscription_count; i++) {
+                free(client->subscriptions[i]);
+            }
+            client->subscription_count = 0;
             if (client->on_disconnect) {
-                client->on_disconnect();
+                client->on_disconnect(client->user);
             }
+            schedule_reconnect(client);
             break;
             
         default:
@@ -64,6 +172,17 @@ static int callback_binance(struct lws *wsi, enum lws_callback_reasons reason,
     return 0;
 }
 
+// Loop time counts callback work only, the idle wait inside lws_service is excluded
+static int callback_binance(struct lws *wsi, enum lws_callback_reasons reason,
+                            void *user, void *in, size_t len) {
+    int64_t start = metrics_clock_ns();
+    int result = handle_callback(wsi, reason, user, in, len);
+    if (serviced_client) {
+        serviced_client->busy_ns += metrics_clock_ns() - start;
+    }
+    return result;
+}
+
 static struct lws_protocols protocols[] = {
     {
         "binance-protocol",
@@ -86,11 +205,18 @@ ws_client_t* ws_client_create(const char *server, int port, const char *path) {
     client->connected = false;
     client->running = false;
     client->subscription_count = 0;
+    client->next_request_id = 1;
     client->use_proxy = false;
     client->proxy_address = NULL;
     client->proxy_port = 0;
     client->proxy_username = NULL;
     client->proxy_password = NULL;
+    client->cpu_affinity = -1;
+    client->send_queue_size = DEFAULT_SEND_QUEUE_SIZE;
+    client->metrics_port = 0;
+    client->reconnect_initial_ms = RECONNECT_INITIAL_MS;
+    client->reconnect_max_ms = RECONNECT_MAX_MS;
+    frame_assembler_init(&client->rx_frame, MAX_MESSAGE_SIZE);
     
     return client;
 }
@@ -119,13 +245,75 @@ void ws_client_set_proxy(ws_client_t *client, const char *proxy_address, int pro
     }
     client->proxy_password = password ? strdup(password) : NULL;
     
-    printf("Proxy configured: %s:%d\n", proxy_address, proxy_port);
+    ws_client_log(client, "Proxy configured: %s:%d", proxy_address, proxy_port);
     if (username) {
-        printf("Proxy authentication enabled\n");
+        ws_client_log(client, "Proxy authentication enabled");
+    }
+}
+
+void ws_client_set_socket_tuning(ws_client_t *client, const socket_tuning_t *tuning) {
+    if (!client || !tuning) {
+        return;
+    }
+    client->socket_tuning = *tuning;
+}
+
+void ws_client_set_cpu_affinity(ws_client_t *client, int cpu) {
+    if (!client) {
+        return;
+    }
+    client->cpu_affinity = cpu;
+}
+
+void ws_client_set_send_queue_size(ws_client_t *client, int size) {
+    if (!client || size <= 0) {
+        return;
+    }
+    client->send_queue_size = size;
+}
+
+void ws_client_set_metrics_port(ws_client_t *client, int port) {
+    if (!client) {
+        return;
+    }
+    client->metrics_port = port;
+}
+
+void ws_client_set_reconnect(ws_client_t *client, int initial_ms, int max_ms) {
+    if (!client) {
+        return;
     }
+    client->reconnect_initial_ms = initial_ms > 0 ? initial_ms : 0;
+    client->reconnect_max_ms = max_ms > client->reconnect_initial_ms ? max_ms
+                                                                     : client->reconnect_initial_ms;
+}
+
+void ws_client_log(const ws_client_t *client, const char *format, ...) {
+    if (!client || !client->on_log) {
+        return;
+    }
+
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    client->on_log(client->user, message);
+}
+
+int64_t ws_client_rx_timestamp(const ws_client_t *client) {
+    return client ? client->rx_timestamp_ns : 0;
 }
 
 int ws_client_connect(ws_client_t *client) {
+    if (!client->send_queue) {
+        client->send_queue = send_queue_create((size_t)client->send_queue_size, LWS_PRE);
+        if (!client->send_queue) {
+            fprintf(stderr, "Failed to allocate send queue\n");
+            return -1;
+        }
+    }
+    
     struct lws_context_creation_info info;
     memset(&info, 0, sizeof(info));
     
@@ -140,7 +328,7 @@ int ws_client_connect(ws_client_t *client) {
     if (client->use_proxy && client->proxy_address) {
         info.http_proxy_address = client->proxy_address;
         info.http_proxy_port = client->proxy_port;
-        printf("Using proxy: %s:%d\n", client->proxy_address, client->proxy_port);
+        ws_client_log(client, "Using proxy: %s:%d", client->proxy_address, client->proxy_port);
     }
     
     client->context = lws_create_context(&info);
@@ -149,6 +337,27 @@ int ws_client_connect(ws_client_t *client) {
         return -1;
     }
     
+    // Metrics endpoint shares the context and service loop, failure is not fatal
+    if (client->metrics_port > 0 &&
+        metrics_http_listen(client->context, "127.0.0.1", client->metrics_port) == 0) {
+        ws_client_log(client, "Serving metrics on http://127.0.0.1:%d/metrics", client->metrics_port);
+    }
+    
+    client->running = true;
+    client->reconnect_delay_ms = client->reconnect_initial_ms;
+    client->reconnect_attempts = 0;
+    if (open_connection(client) < 0) {
+        fprintf(stderr, "Failed to connect to WebSocket server\n");
+        client->running = false;
+        lws_context_destroy(client->context);
+        client->context = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Start a connection on the existing context
+static int open_connection(ws_client_t *client) {
     struct lws_client_connect_info ccinfo;
     memset(&ccinfo, 0, sizeof(ccinfo));
     
@@ -162,102 +371,232 @@ int ws_client_connect(ws_client_t *client) {
     ccinfo.ssl_connection = LCCSCF_USE_SSL | LCCSCF_ALLOW_SELFSIGNED | LCCSCF_SKIP_SERVER_CERT_HOSTNAME_CHECK;
     ccinfo.userdata = client;
     
-    client->wsi = lws_client_connect_via_info(&ccinfo);
-    if (!client->wsi) {
-        fprintf(stderr, "Failed to connect to WebSocket server\n");
-        lws_context_destroy(client->context);
-        return -1;
+    client->reconnect_at_ns = 0;
+    struct lws *wsi = lws_client_connect_via_info(&ccinfo);
+    // A failure reported from inside the call has already scheduled the next attempt
+    if (client->reconnect_at_ns == 0) {
+        client->wsi = wsi;
+    }
+    return wsi ? 0 : -1;
+}
+
+static void reconnect_if_due(ws_client_t *client) {
+    if (client->wsi || client->reconnect_at_ns == 0 ||
+        metrics_clock_ns() < client->reconnect_at_ns) {
+        return;
+    }
+
+    client->reconnect_attempts++;
+    metrics_inc(METRIC_RECONNECTS);
+    ws_client_log(client, "Reconnecting to %s:%d (attempt %d)", client->server_address,
+                  client->port, client->reconnect_attempts);
+    if (open_connection(client) < 0 && client->reconnect_at_ns == 0) {
+        schedule_reconnect(client);
     }
-    
-    client->running = true;
-    return 0;
 }
 
 int ws_client_send(ws_client_t *client, const char *message) {
-    if (!client->connected) {
+    if (!client->connected || !client->send_queue) {
         fprintf(stderr, "WebSocket not connected\n");
         return -1;
     }
     
-    size_t len = strlen(message);
-    unsigned char *buf = (unsigned char *)malloc(LWS_PRE + len);
-    if (!buf) {
+    if (send_queue_push(client->send_queue, message, strlen(message)) < 0) {
+        fprintf(stderr, "Send queue full or message too large, dropping message\n");
+        metrics_inc(METRIC_SEND_DROPS);
         return -1;
     }
     
-    memcpy(&buf[LWS_PRE], message, len);
-    
-    int n = lws_write(client->wsi, &buf[LWS_PRE], len, LWS_WRITE_TEXT);
-    free(buf);
-    
-    if (n < 0) {
-        fprintf(stderr, "Failed to send message\n");
-        return -1;
+    // On the service thread ask for WRITEABLE directly, elsewhere wake the loop
+    // and let LWS_CALLBACK_EVENT_WAIT_CANCELLED do it
+    if (serviced_client == client) {
+        lws_callback_on_writable(client->wsi);
+    } else {
+        lws_cancel_service(client->context);
     }
     
     return 0;
 }
 
-int ws_client_subscribe(ws_client_t *client, const char *stream) {
-    if (client->subscription_count >= MAX_SUBSCRIPTIONS) {
+static int find_subscription(const ws_client_t *client, const char *stream) {
+    for (int i = 0; i < client->subscription_count; i++) {
+        if (strcmp(client->subscriptions[i], stream) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ws_client_subscribe_batch(ws_client_t *client, const char **streams, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    if (client->subscription_count + count > MAX_SUBSCRIPTIONS) {
         fprintf(stderr, "Maximum subscriptions reached\n");
         return -1;
     }
-    
-    // Build subscription JSON
-    char message[1024];
-    snprintf(message, sizeof(message),
-             "{\"method\":\"SUBSCRIBE\",\"params\":[\"%s\"],\"id\":%d}",
-             stream, client->subscription_count + 1);
-    
+
+    char *message = build_subscribe_message(streams, count, client->next_request_id++);
+    if (!message) {
+        return -1;
+    }
+
     int result = ws_client_send(client, message);
+    free(message);
+
     if (result == 0) {
-        client->subscriptions[client->subscription_count] = strdup(stream);
-        client->subscription_count++;
-        printf("Subscribed to: %s\n", stream);
+        for (int i = 0; i < count; i++) {
+            client->subscriptions[client->subscription_count++] = strdup(streams[i]);
+            ws_client_log(client, "Subscribed to: %s", streams[i]);
+        }
     }
-    
+
     return result;
 }
 
-int ws_client_unsubscribe(ws_client_t *client, const char *stream) {
-    // Find the subscription
-    int index = -1;
-    for (int i = 0; i < client->subscription_count; i++) {
-        if (strcmp(client->subscriptions[i], stream) == 0) {
-            index = i;
-            break;
-        }
+int ws_client_unsubscribe_batch(ws_client_t *client, const char **streams, int count) {
+    if (count <= 0) {
+        return 0;
     }
-    
-    if (index == -1) {
-        fprintf(stderr, "Stream not found in subscriptions\n");
+
+    char *message = build_unsubscribe_message(streams, count, client->next_request_id++);
+    if (!message) {
         return -1;
     }
-    
-    // Build unsubscribe JSON
-    char message[1024];
-    snprintf(message, sizeof(message),
-             "{\"method\":\"UNSUBSCRIBE\",\"params\":[\"%s\"],\"id\":%d}",
-             stream, 100 + index);
-    
+
     int result = ws_client_send(client, message);
+    free(message);
+
     if (result == 0) {
-        free(client->subscriptions[index]);
-        // Shift remaining subscriptions
-        for (int i = index; i < client->subscription_count - 1; i++) {
-            client->subscriptions[i] = client->subscriptions[i + 1];
+        for (int i = 0; i < count; i++) {
+            int index = find_subscription(client, streams[i]);
+            if (index == -1) {
+                continue;
+            }
+            free(client->subscriptions[index]);
+            // Shift remaining subscriptions
+            for (int j = index; j < client->subscription_count - 1; j++) {
+                client->subscriptions[j] = client->subscriptions[j + 1];
+            }
+            client->subscription_count--;
+            ws_client_log(client, "Unsubscribed from: %s", streams[i]);
         }
-        client->subscription_count--;
-        printf("Unsubscribed from: %s\n", stream);
     }
-    
+
     return result;
 }
 
+int ws_client_subscribe(ws_client_t *client, const char *stream) {
+    if (find_subscription(client, stream) != -1) {
+        return 0;
+    }
+    return ws_client_subscribe_batch(client, &stream, 1);
+}
+
+int ws_client_unsubscribe(ws_client_t *client, const char *stream) {
+    if (find_subscription(client, stream) == -1) {
+        fprintf(stderr, "Stream not found in subscriptions\n");
+        return -1;
+    }
+    return ws_client_unsubscribe_batch(client, &stream, 1);
+}
+
+int ws_client_update_subscriptions(ws_client_t *client, const char **streams, int count) {
+    const char *to_add[MAX_SUBSCRIPTIONS];
+    const char *to_remove[MAX_SUBSCRIPTIONS];
+    int add_count = 0;
+    int remove_count = 0;
+
+    // Streams we hold that are no longer wanted
+    for (int i = 0; i < client->subscription_count; i++) {
+        bool wanted = false;
+        for (int j = 0; j < count; j++) {
+            if (strcmp(client->subscriptions[i], streams[j]) == 0) {
+                wanted = true;
+                break;
+            }
+        }
+        if (!wanted) {
+            to_remove[remove_count++] = client->subscriptions[i];
+        }
+    }
+
+    // Wanted streams we do not hold yet
+    for (int j = 0; j < count && add_count < MAX_SUBSCRIPTIONS; j++) {
+        if (find_subscription(client, streams[j]) != -1) {
+            continue;
+        }
+        bool duplicate = false;
+        for (int k = 0; k < add_count; k++) {
+            if (strcmp(to_add[k], streams[j]) == 0) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            to_add[add_count++] = streams[j];
+        }
+    }
+
+    if (add_count == 0 && remove_count == 0) {
+        ws_client_log(client, "Subscriptions unchanged");
+        return 0;
+    }
+
+    ws_client_log(client, "Updating subscriptions: +%d -%d", add_count, remove_count);
+
+    // Copy names first, unsubscribing frees the strings we point at
+    char *removed[MAX_SUBSCRIPTIONS];
+    for (int i = 0; i < remove_count; i++) {
+        removed[i] = strdup(to_remove[i]);
+    }
+
+    int result = ws_client_unsubscribe_batch(client, (const char **)removed, remove_count);
+    for (int i = 0; i < remove_count; i++) {
+        free(removed[i]);
+    }
+    if (result < 0) {
+        return result;
+    }
+
+    return ws_client_subscribe_batch(client, to_add, add_count);
+}
+
+int ws_client_service(ws_client_t *client, int timeout_ms) {
+    if (!client->running || !client->context) {
+        return -1;
+    }
+    // Set only while servicing, so a thread that polls and later sends from
+    // elsewhere still wakes the loop
+    ws_client_t *previous = serviced_client;
+    serviced_client = client;
+    
+    client->busy_ns = 0;
+    lws_service(client->context, timeout_ms);
+    int64_t start = metrics_clock_ns();
+    reconnect_if_due(client);
+    if (client->on_tick) {
+        client->on_tick(client->user);
+    }
+    
+    int64_t elapsed = client->busy_ns + (metrics_clock_ns() - start);
+    metrics_inc(METRIC_LOOP_ITERATIONS);
+    metrics_add(METRIC_LOOP_NANOSECONDS, (uint64_t)elapsed);
+    metrics_gauge_set(METRIC_LOOP_LAST_NS, elapsed);
+    metrics_gauge_set(METRIC_CONNECTED, client->connected ? 1 : 0);
+    metrics_gauge_set(METRIC_SUBSCRIPTIONS, client->subscription_count);
+    metrics_gauge_set(METRIC_SEND_QUEUE_DEPTH, (int64_t)send_queue_depth(client->send_queue));
+    serviced_client = previous;
+    return 0;
+}
+
 void ws_client_run(ws_client_t *client) {
-    while (client->running && client->context) {
-        lws_service(client->context, 50);
+    if (client->cpu_affinity >= 0 && socket_tuning_set_thread_cpu(client->cpu_affinity) == 0) {
+        ws_client_log(client, "Service loop pinned to CPU %d", client->cpu_affinity);
+    }
+    
+    while (ws_client_service(client, 50) == 0) {
     }
 }
 
@@ -286,6 +625,8 @@ void ws_client_destroy(ws_client_t *client) {
     free(client->proxy_username);
     free(client->proxy_password);
     
+    frame_assembler_free(&client->rx_frame);
+    send_queue_destroy(client->send_queue);
     free(client->server_address);
     free(client->path);
     free(client);
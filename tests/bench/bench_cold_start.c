@@ -0,0 +1,117 @@
+#include "depth_sync.h"
+#include "mock_http_server.h"
+#include "bench_util.h"
+#include <unistd.h>
+
+// Cold start of many order books against a local snapshot server: time from
+// tracking every symbol until all books are live. Each symbol has a buffered
+// diff straddling the snapshot, so a book goes live as soon as its snapshot is
+// merged. The request weight budget is lifted so the pipeline, not the
+// exchange limit, is measured.
+
+#define ROUNDS 3
+
+static double cold_start(int port, int symbols, int levels, int max_in_flight) {
+    struct lws_context_creation_info info;
+    memset(&info, 0, sizeof(info));
+    info.port = CONTEXT_PORT_NO_LISTEN;
+    struct lws_context *context = lws_create_context(&info);
+    depth_sync_t *sync = depth_sync_create(context, "127.0.0.1", port, false, levels,
+                                           max_in_flight, 1000000);
+    if (!sync) {
+        lws_context_destroy(context);
+        return -1.0;
+    }
+
+    double start = bench_now();
+    char symbol[DEPTH_SYNC_SYMBOL_SIZE];
+    double price = 100.0, quantity = 1.0;
+    for (int i = 0; i < symbols; i++) {
+        snprintf(symbol, sizeof(symbol), "SYM%dUSDT", i);
+        depth_sync_track(sync, symbol);
+
+        market_data_t data;
+        memset(&data, 0, sizeof(data));
+        data.event = MARKET_EVENT_DEPTH;
+        data.symbol = symbol;
+        data.first_update_id = 99;
+        data.final_update_id = 101;
+        data.prev_final_update_id = 98;
+        data.bid_prices = &price;
+        data.bid_quantities = &quantity;
+        data.bid_count = 1;
+        depth_sync_update(sync, &data);
+    }
+
+    double elapsed = -1.0;
+    while (bench_now() - start < 30.0) {
+        depth_sync_pump(sync);
+        lws_service(context, 1);
+        if (sync->live_count == symbols) {
+            elapsed = bench_now() - start;
+            break;
+        }
+    }
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    const char *baseline = NULL;
+    const char *record = NULL;
+    double tolerance = 15.0;
+    int symbols = 200;
+    int levels = 1000;
+    int max_in_flight = 10;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:r:t:n:l:f:")) != -1) {
+        switch (opt) {
+            case 'b': baseline = optarg; break;
+            case 'r': record = optarg; break;
+            case 't': tolerance = atof(optarg); break;
+            case 'n': symbols = atoi(optarg); break;
+            case 'l': levels = atoi(optarg); break;
+            case 'f': max_in_flight = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-b baseline] [-r record] [-t tolerance%%] [-n symbols] "
+                                "[-l levels] [-f in flight]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    mock_http_server_t server;
+    if (mock_http_start(&server, levels, 100) < 0) {
+        fprintf(stderr, "Cannot listen on loopback\n");
+        return 2;
+    }
+
+    double best = -1.0;
+    for (int round = 0; round < ROUNDS; round++) {
+        double elapsed = cold_start(server.port, symbols, levels, max_in_flight);
+        if (elapsed < 0.0) {
+            fprintf(stderr, "Books not consistent after 30 s\n");
+            mock_http_stop(&server);
+            return 1;
+        }
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    mock_http_stop(&server);
+
+    bench_results_t results;
+    memset(&results, 0, sizeof(results));
+    bench_add(&results, "cold_start_books_per_sec", (double)symbols / best);
+    printf("%d books of %d levels consistent after %.1f ms (%d snapshots in flight)\n",
+           symbols, levels, best * 1e3, max_in_flight);
+
+    if (record) {
+        return bench_record(&results, record) < 0 ? 1 : 0;
+    }
+    if (baseline) {
+        return bench_gate(&results, baseline, tolerance);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "json_parser.h"
+#include "bench_util.h"
+#include <stdbool.h>
+#include <unistd.h>
+
+// Parser throughput on a recorded message corpus (one message per line): the
+// generic parser over the whole mix, each specialized parser over its events
+// and the json-c reference for comparison. Best of several rounds, in msgs/sec.
+
+#define MAX_MESSAGES 65536
+#define ROUNDS 5
+
+typedef struct {
+    char *text;
+    size_t len;
+    market_event_t event;
+} message_t;
+
+static message_t messages[MAX_MESSAGES];
+static int message_count = 0;
+
+static int load_corpus(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t len;
+    while (message_count < MAX_MESSAGES && (len = getline(&line, &capacity, file)) > 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        market_data_t *data = parse_market_data_reference(line, (size_t)len);
+        message_t *message = &messages[message_count++];
+        message->text = strdup(line);
+        message->len = (size_t)len;
+        message->event = data ? data->event : MARKET_EVENT_NONE;
+        free_market_data(data);
+    }
+    free(line);
+    fclose(file);
+    return message_count > 0 ? 0 : -1;
+}
+
+// Messages per second of parser over the corpus messages of event (NONE: all)
+static double measure(market_parser_fn parser, market_event_t event, double seconds) {
+    double best = 0.0;
+    for (int round = 0; round < ROUNDS; round++) {
+        long parsed = 0;
+        double start = bench_now();
+        double elapsed;
+        do {
+            for (int i = 0; i < message_count; i++) {
+                if (event != MARKET_EVENT_NONE && messages[i].event != event) {
+                    continue;
+                }
+                free_market_data(parser(messages[i].text, messages[i].len));
+                parsed++;
+            }
+            elapsed = bench_now() - start;
+        } while (elapsed < seconds / ROUNDS && parsed > 0);
+
+        if (parsed > 0 && (double)parsed / elapsed > best) {
+            best = (double)parsed / elapsed;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    const char *baseline = NULL;
+    const char *record = NULL;
+    double tolerance = 15.0;
+    double seconds = 2.5;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:r:t:s:")) != -1) {
+        switch (opt) {
+            case 'b': baseline = optarg; break;
+            case 'r': record = optarg; break;
+            case 't': tolerance = atof(optarg); break;
+            case 's': seconds = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-b baseline] [-r record] [-t tolerance%%] [-s seconds] corpus\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc || load_corpus(argv[optind]) < 0) {
+        fprintf(stderr, "No corpus loaded\n");
+        return 2;
+    }
+
+    bench_results_t results;
+    memset(&results, 0, sizeof(results));
+    bench_add(&results, "generic", measure(parse_market_data, MARKET_EVENT_NONE, seconds));
+    for (int event = 1; event < MARKET_EVENT_COUNT; event++) {
+        bool present = false;
+        for (int i = 0; i < message_count && !present; i++) {
+            present = messages[i].event == (market_event_t)event;
+        }
+        if (present) {
+            bench_add(&results, market_event_name((market_event_t)event),
+                      measure(market_parser_for((market_event_t)event), (market_event_t)event, seconds));
+        }
+    }
+    bench_add(&results, "reference", measure(parse_market_data_reference, MARKET_EVENT_NONE, seconds));
+
+    printf("%d messages\n", message_count);
+    for (int i = 0; i < results.count; i++) {
+        printf("%-24s %12.0f msgs/sec\n", results.results[i].name, results.results[i].value);
+    }
+
+    int result = 0;
+    if (record) {
+        result = bench_record(&results, record) < 0 ? 1 : 0;
+    } else if (baseline) {
+        result = bench_gate(&results, baseline, tolerance);
+    }
+
+    for (int i = 0; i < message_count; i++) {
+        free(messages[i].text);
+    }
+    free_parser_thread_state();
+    return result;
+}
\ No newline at end of file
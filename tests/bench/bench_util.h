@@ -0,0 +1,80 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Throughput baselines: one "name value" line per measurement, higher is better.
+// A run fails when a measurement drops more than tolerance percent below its
+// baseline; a missing baseline file is recorded from the current run.
+
+#define BENCH_MAX_RESULTS 32
+
+typedef struct {
+    char name[64];
+    double value;
+} bench_result_t;
+
+typedef struct {
+    bench_result_t results[BENCH_MAX_RESULTS];
+    int count;
+} bench_results_t;
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static inline void bench_add(bench_results_t *results, const char *name, double value) {
+    if (results->count < BENCH_MAX_RESULTS) {
+        bench_result_t *result = &results->results[results->count++];
+        snprintf(result->name, sizeof(result->name), "%s", name);
+        result->value = value;
+    }
+}
+
+static inline int bench_record(const bench_results_t *results, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+    for (int i = 0; i < results->count; i++) {
+        fprintf(file, "%s %.0f\n", results->results[i].name, results->results[i].value);
+    }
+    fclose(file);
+    printf("Baseline recorded to %s\n", path);
+    return 0;
+}
+
+// 0 when every baselined measurement is within tolerance, 1 otherwise
+static inline int bench_gate(const bench_results_t *results, const char *path, double tolerance) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return bench_record(results, path) < 0 ? 1 : 0;
+    }
+
+    int failed = 0;
+    char name[64];
+    double baseline;
+    while (fscanf(file, "%63s %lf", name, &baseline) == 2) {
+        for (int i = 0; i < results->count; i++) {
+            const bench_result_t *result = &results->results[i];
+            if (strcmp(result->name, name) != 0) {
+                continue;
+            }
+            double floor = baseline * (1.0 - tolerance / 100.0);
+            bool below = result->value < floor;
+            printf("%-24s %12.0f baseline %12.0f %+6.1f%%%s\n", name, result->value, baseline,
+                   (result->value / baseline - 1.0) * 100.0, below ? "  REGRESSION" : "");
+            failed |= below;
+        }
+    }
+    fclose(file);
+    return failed;
+}
+
+#endif // BENCH_UTIL_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Runs a fuzz target without libFuzzer: on every corpus file or directory given,
+// or on stdin when none is, which is how AFL drives it
+// (afl-fuzz -i tests/fuzz/corpus/parser -o findings -- ./fuzz_parser_replay).
+// -m N also runs N deterministic mutations of each input, a quick smoke test for ctest.
+
+#define MAX_INPUT (1024 * 1024)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static const char mutation_bytes[] = "{}[]\",:0123456789.-+eEtrufalsn pbBaAqsSTUumkl\\\x80\xff";
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Replace, insert or delete a few bytes
+static size_t mutate(uint8_t *buf, size_t len, size_t capacity) {
+    int edits = 1 + (int)(next_random() % 4);
+    for (int i = 0; i < edits; i++) {
+        size_t pos = len ? next_random() % len : 0;
+        uint8_t byte = (uint8_t)mutation_bytes[next_random() % (sizeof(mutation_bytes) - 1)];
+        switch (next_random() % 3) {
+            case 0:
+                if (len) {
+                    buf[pos] = byte;
+                }
+                break;
+            case 1:
+                if (len < capacity) {
+                    memmove(buf + pos + 1, buf + pos, len - pos);
+                    buf[pos] = byte;
+                    len++;
+                }
+                break;
+            default:
+                if (len) {
+                    memmove(buf + pos, buf + pos + 1, len - pos - 1);
+                    len--;
+                }
+                break;
+        }
+    }
+    return len;
+}
+
+static int run_input(const uint8_t *data, size_t len, long mutations) {
+    LLVMFuzzerTestOneInput(data, len);
+
+    uint8_t *buf = (uint8_t *)malloc(len + 64);
+    if (!buf) {
+        return -1;
+    }
+    for (long i = 0; i < mutations; i++) {
+        memcpy(buf, data, len);
+        size_t n = mutate(buf, len, len + 64);
+        LLVMFuzzerTestOneInput(buf, n);
+    }
+    free(buf);
+    return 0;
+}
+
+static int run_file(const char *path, long mutations) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    uint8_t *data = (uint8_t *)malloc(MAX_INPUT);
+    size_t len = data ? fread(data, 1, MAX_INPUT, file) : 0;
+    fclose(file);
+    if (!data) {
+        return -1;
+    }
+
+    int result = run_input(data, len, mutations);
+    free(data);
+    return result;
+}
+
+static int run_path(const char *path, long mutations, int *inputs) {
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        perror(path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        (*inputs)++;
+        return run_file(path, mutations);
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return -1;
+    }
+    int result = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char child[4096];
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        if (run_path(child, mutations, inputs) < 0) {
+            result = -1;
+        }
+    }
+    closedir(dir);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    long mutations = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:")) != -1) {
+        if (opt == 'm') {
+            mutations = atol(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-m mutations] [corpus file or directory...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind == argc) {
+        uint8_t *data = (uint8_t *)malloc(MAX_INPUT);
+        size_t len = data ? fread(data, 1, MAX_INPUT, stdin) : 0;
+        int result = data ? run_input(data, len, mutations) : -1;
+        free(data);
+        return result < 0 ? 1 : 0;
+    }
+
+    int inputs = 0;
+    int result = 0;
+    for (int i = optind; i < argc; i++) {
+        if (run_path(argv[i], mutations, &inputs) < 0) {
+            result = -1;
+        }
+    }
+    printf("%d inputs, %ld mutations each\n", inputs, mutations);
+    return result < 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "frame_assembler.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Frame reassembly target. The input is a sequence of fragments, each a control
+// byte (bits 0-5 length, bit 6 first, bit 7 final) followed by its payload. The
+// assembler is checked against a plain model of the message being collected.
+
+#define MAX_MESSAGE 256
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    frame_assembler_t assembler;
+    frame_assembler_init(&assembler, MAX_MESSAGE);
+
+    char model[MAX_MESSAGE];
+    size_t model_len = 0;
+    bool in_message = false;
+    bool too_large = false;
+
+    size_t pos = 0;
+    while (pos < size) {
+        uint8_t control = data[pos++];
+        size_t len = control & 0x3f;
+        bool first = (control & 0x40) != 0;
+        bool final = (control & 0x80) != 0;
+        if (len > size - pos) {
+            len = size - pos;
+        }
+
+        if (first || !in_message) {
+            model_len = 0;
+            too_large = false;
+            in_message = true;
+        }
+        if (!too_large) {
+            if (model_len + len > MAX_MESSAGE) {
+                too_large = true;
+            } else {
+                memcpy(model + model_len, data + pos, len);
+                model_len += len;
+            }
+        }
+
+        frame_status_t status = frame_assembler_push(&assembler, data + pos, len, first, final);
+        pos += len;
+
+        if (!final) {
+            if (status != FRAME_PARTIAL) {
+                fprintf(stderr, "Fragment without final flag completed a message\n");
+                abort();
+            }
+            continue;
+        }
+
+        in_message = false;
+        if (too_large) {
+            if (status != FRAME_DROPPED) {
+                fprintf(stderr, "Message over %d bytes was not dropped\n", MAX_MESSAGE);
+                abort();
+            }
+            continue;
+        }
+        if (status != FRAME_COMPLETE || assembler.len != model_len ||
+            memcmp(assembler.buffer, model, model_len) != 0 || assembler.buffer[model_len] != '\0') {
+            fprintf(stderr, "Reassembled message differs from its fragments (%zu vs %zu bytes)\n",
+                    assembler.len, model_len);
+            abort();
+        }
+    }
+
+    frame_assembler_free(&assembler);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "json_parser.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Differential target: every parser, generic and specialized, must agree field by
+// field with the json-c reference whenever either side yields an event
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static void check(const char *name, const market_data_t *fast, const market_data_t *reference,
+                  const char *input, size_t size) {
+    bool fast_event = fast && fast->event != MARKET_EVENT_NONE;
+    bool reference_event = reference && reference->event != MARKET_EVENT_NONE;
+    if (!fast_event && !reference_event) {
+        return;
+    }
+
+    const char *field = market_data_compare(fast, reference);
+    if (field) {
+        fprintf(stderr, "%s differs from the reference in %s: %.*s\n", name, field,
+                (int)(size < 1024 ? size : 1024), input);
+        abort();
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    // Parsers get NUL terminated input, as from the frame assembler
+    char *input = (char *)malloc(size + 1);
+    if (!input) {
+        return 0;
+    }
+    memcpy(input, data, size);
+    input[size] = '\0';
+
+    market_data_t *reference = parse_market_data_reference(input, size);
+    for (int event = MARKET_EVENT_NONE; event < MARKET_EVENT_COUNT; event++) {
+        market_data_t *fast = market_parser_for((market_event_t)event)(input, size);
+        check(market_event_name((market_event_t)event), fast, reference, input, size);
+        free_market_data(fast);
+    }
+    free_market_data(reference);
+
+    // Snapshot parser: memory safety only
+    free_market_data(parse_depth_snapshot(input, size));
+
+    free(input);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#ifndef MOCK_HTTP_SERVER_H
+#define MOCK_HTTP_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Stand-in for the REST depth endpoint on 127.0.0.1: answers every
+// GET /fapi/v1/depth?symbol=... with a snapshot of `levels` levels per side
+// at the current last update id, one request per connection.
+typedef struct {
+    int listen_fd;
+    int port;
+    pthread_t thread;
+    atomic_bool running;
+    atomic_int requests;
+    atomic_long last_update_id;
+    atomic_int status;
+    int levels;
+} mock_http_server_t;
+
+static char* mock_snapshot_body(const mock_http_server_t *server, size_t *len) {
+    char *body = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&body, &size);
+    if (!out) {
+        return NULL;
+    }
+    fprintf(out, "{\"lastUpdateId\":%ld,\"E\":1,\"T\":1,\"bids\":[",
+            atomic_load(&server->last_update_id));
+    for (int i = 0; i < server->levels; i++) {
+        fprintf(out, "%s[\"%.2f\",\"1.000\"]", i ? "," : "", 100.0 - i * 0.01);
+    }
+    fprintf(out, "],\"asks\":[");
+    for (int i = 0; i < server->levels; i++) {
+        fprintf(out, "%s[\"%.2f\",\"2.000\"]", i ? "," : "", 101.0 + i * 0.01);
+    }
+    fprintf(out, "]}");
+    fclose(out);
+    *len = size;
+    return body;
+}
+
+static void mock_serve(mock_http_server_t *server, int fd) {
+    char request[2048];
+    size_t used = 0;
+    while (used < sizeof(request) - 1) {
+        ssize_t n = read(fd, request + used, sizeof(request) - 1 - used);
+        if (n <= 0) {
+            return;
+        }
+        used += (size_t)n;
+        request[used] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+    atomic_fetch_add(&server->requests, 1);
+
+    int status = atomic_load(&server->status);
+    size_t len = 0;
+    char *body = status == 200 ? mock_snapshot_body(server, &len) : NULL;
+    char header[256];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                              "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                              status, status == 200 ? "OK" : "Error", len);
+    if (send(fd, header, (size_t)header_len, MSG_NOSIGNAL) == header_len) {
+        for (size_t sent = 0; sent < len;) {
+            ssize_t n = send(fd, body + sent, len - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += (size_t)n;
+        }
+    }
+    free(body);
+}
+
+static void* mock_http_thread(void *arg) {
+    mock_http_server_t *server = (mock_http_server_t *)arg;
+    while (atomic_load(&server->running)) {
+        struct pollfd pfd = { .fd = server->listen_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        mock_serve(server, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+// Listen on an ephemeral loopback port, -1 on failure
+static int mock_http_start(mock_http_server_t *server, int levels, long last_update_id) {
+    memset(server, 0, sizeof(*server));
+    server->levels = levels;
+    atomic_store(&server->last_update_id, last_update_id);
+    atomic_store(&server->status, 200);
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server->listen_fd, 256) < 0 ||
+        getsockname(server->listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        close(server->listen_fd);
+        return -1;
+    }
+    server->port = ntohs(addr.sin_port);
+
+    atomic_store(&server->running, true);
+    if (pthread_create(&server->thread, NULL, mock_http_thread, server) != 0) {
+        close(server->listen_fd);
+        return -1;
+    }
+    return 0;
+}
+
+static void mock_http_stop(mock_http_server_t *server) {
+    atomic_store(&server->running, false);
+    pthread_join(server->thread, NULL);
+    close(server->listen_fd);
+}
+
+#endif // MOCK_HTTP_SERVER_H
\ No newline at end of file
@@ -0,0 +1,287 @@
+#ifndef MOCK_WS_SERVER_H
+#define MOCK_WS_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MOCK_WS_MAX_FRAMES 256
+
+// Stand-in for the market data WebSocket on 127.0.0.1: TLS with a throwaway
+// self-signed certificate, one connection at a time. Every connection gets
+// `greeting` as a text frame right after the handshake; text frames from the
+// client are kept in order. Setting drop closes the current connection.
+typedef struct {
+    int listen_fd;
+    int port;
+    pthread_t thread;
+    SSL_CTX *ssl_ctx;
+    atomic_bool running;
+    atomic_bool drop;
+    atomic_int connections;
+    const char *greeting;
+
+    pthread_mutex_t lock;
+    char *frames[MOCK_WS_MAX_FRAMES];
+    int frame_count;
+} mock_ws_server_t;
+
+// Self-signed P-256 certificate for CN=127.0.0.1, valid for a day
+static int mock_ws_certificate(SSL_CTX *ctx) {
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    if (!key || !cert) {
+        EVP_PKEY_free(key);
+        X509_free(cert);
+        return -1;
+    }
+
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 86400);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"127.0.0.1",
+                               -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    int result = X509_sign(cert, key, EVP_sha256()) > 0 &&
+                 SSL_CTX_use_certificate(ctx, cert) == 1 &&
+                 SSL_CTX_use_PrivateKey(ctx, key) == 1 ? 0 : -1;
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return result;
+}
+
+static int mock_ws_write(SSL *ssl, const void *data, size_t len) {
+    return SSL_write(ssl, data, (int)len) == (int)len ? 0 : -1;
+}
+
+// Server frames are never masked
+static int mock_ws_send_text(SSL *ssl, const char *text) {
+    size_t len = strlen(text);
+    unsigned char header[4];
+    size_t header_len = 0;
+    header[header_len++] = 0x81;
+    if (len < 126) {
+        header[header_len++] = (unsigned char)len;
+    } else {
+        header[header_len++] = 126;
+        header[header_len++] = (unsigned char)(len >> 8);
+        header[header_len++] = (unsigned char)len;
+    }
+    if (mock_ws_write(ssl, header, header_len) < 0) {
+        return -1;
+    }
+    return mock_ws_write(ssl, text, len);
+}
+
+// Read the upgrade request and answer with 101, -1 on anything else
+static int mock_ws_handshake(SSL *ssl) {
+    char request[4096];
+    size_t used = 0;
+    while (used < sizeof(request) - 1) {
+        if (SSL_read(ssl, request + used, 1) != 1) {
+            return -1;
+        }
+        request[++used] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+
+    const char *key = NULL;
+    for (const char *line = request; line && *line; line = strstr(line, "\r\n")) {
+        line += line[0] == '\r' ? 2 : 0;
+        if (strncasecmp(line, "Sec-WebSocket-Key:", 18) == 0) {
+            key = line + 18;
+            break;
+        }
+    }
+    if (!key) {
+        return -1;
+    }
+    while (*key == ' ') {
+        key++;
+    }
+
+    char accept_source[128];
+    int key_len = (int)strcspn(key, "\r\n");
+    snprintf(accept_source, sizeof(accept_source), "%.*s258EAFA5-E914-47DA-95CA-C5AB0DC85B11",
+             key_len, key);
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1((const unsigned char *)accept_source, strlen(accept_source), digest);
+    unsigned char accept[64];
+    EVP_EncodeBlock(accept, digest, SHA_DIGEST_LENGTH);
+
+    char response[512];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                       "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n"
+                       "Sec-WebSocket-Protocol: binance-protocol\r\n\r\n", accept);
+    return mock_ws_write(ssl, response, (size_t)len);
+}
+
+// Collect masked client text frames until the client leaves, drop is set or the server stops
+static void mock_ws_receive(mock_ws_server_t *server, SSL *ssl, int fd) {
+    unsigned char buffer[65536];
+    size_t used = 0;
+    while (atomic_load(&server->running) && !atomic_load(&server->drop)) {
+        if (!SSL_pending(ssl)) {
+            struct pollfd pfd = { .fd = fd, .events = POLLIN };
+            if (poll(&pfd, 1, 10) <= 0) {
+                continue;
+            }
+        }
+        int n = SSL_read(ssl, buffer + used, (int)(sizeof(buffer) - used));
+        if (n <= 0) {
+            return;
+        }
+        used += (size_t)n;
+
+        size_t offset = 0;
+        while (used - offset >= 6) {
+            const unsigned char *frame = buffer + offset;
+            size_t len = frame[1] & 0x7f;
+            size_t header = 2;
+            if (len == 126) {
+                len = ((size_t)frame[2] << 8) | frame[3];
+                header = 4;
+            }
+            if (used - offset < header + 4 + len) {
+                break;
+            }
+            const unsigned char *mask = frame + header;
+            const unsigned char *payload = mask + 4;
+            if ((frame[0] & 0x0f) == 0x8) {
+                return;
+            }
+            char *text = (char *)malloc(len + 1);
+            for (size_t i = 0; i < len; i++) {
+                text[i] = (char)(payload[i] ^ mask[i & 3]);
+            }
+            text[len] = '\0';
+            pthread_mutex_lock(&server->lock);
+            if (server->frame_count < MOCK_WS_MAX_FRAMES) {
+                server->frames[server->frame_count++] = text;
+            } else {
+                free(text);
+            }
+            pthread_mutex_unlock(&server->lock);
+            offset += header + 4 + len;
+        }
+        memmove(buffer, buffer + offset, used - offset);
+        used -= offset;
+    }
+}
+
+static void* mock_ws_thread(void *arg) {
+    mock_ws_server_t *server = (mock_ws_server_t *)arg;
+    while (atomic_load(&server->running)) {
+        struct pollfd pfd = { .fd = server->listen_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+
+        SSL *ssl = SSL_new(server->ssl_ctx);
+        SSL_set_fd(ssl, fd);
+        if (SSL_accept(ssl) == 1 && mock_ws_handshake(ssl) == 0) {
+            atomic_store(&server->drop, false);
+            atomic_fetch_add(&server->connections, 1);
+            if (!server->greeting || mock_ws_send_text(ssl, server->greeting) == 0) {
+                mock_ws_receive(server, ssl, fd);
+            }
+        }
+        SSL_free(ssl);
+        close(fd);
+    }
+    return NULL;
+}
+
+// Listen on an ephemeral loopback port, -1 on failure
+static int mock_ws_start(mock_ws_server_t *server, const char *greeting) {
+    memset(server, 0, sizeof(*server));
+    server->greeting = greeting;
+    pthread_mutex_init(&server->lock, NULL);
+
+    server->ssl_ctx = SSL_CTX_new(TLS_server_method());
+    if (!server->ssl_ctx || mock_ws_certificate(server->ssl_ctx) < 0) {
+        SSL_CTX_free(server->ssl_ctx);
+        return -1;
+    }
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        SSL_CTX_free(server->ssl_ctx);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server->listen_fd, 16) < 0 ||
+        getsockname(server->listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        close(server->listen_fd);
+        SSL_CTX_free(server->ssl_ctx);
+        return -1;
+    }
+    server->port = ntohs(addr.sin_port);
+
+    atomic_store(&server->running, true);
+    if (pthread_create(&server->thread, NULL, mock_ws_thread, server) != 0) {
+        close(server->listen_fd);
+        SSL_CTX_free(server->ssl_ctx);
+        return -1;
+    }
+    return 0;
+}
+
+// Copy of the index-th client frame, NULL while it has not arrived
+static inline char* mock_ws_frame(mock_ws_server_t *server, int index) {
+    pthread_mutex_lock(&server->lock);
+    char *frame = index < server->frame_count ? strdup(server->frames[index]) : NULL;
+    pthread_mutex_unlock(&server->lock);
+    return frame;
+}
+
+static inline int mock_ws_frame_count(mock_ws_server_t *server) {
+    pthread_mutex_lock(&server->lock);
+    int count = server->frame_count;
+    pthread_mutex_unlock(&server->lock);
+    return count;
+}
+
+static void mock_ws_stop(mock_ws_server_t *server) {
+    atomic_store(&server->running, false);
+    pthread_join(server->thread, NULL);
+    close(server->listen_fd);
+    SSL_CTX_free(server->ssl_ctx);
+    for (int i = 0; i < server->frame_count; i++) {
+        free(server->frames[i]);
+    }
+    pthread_mutex_destroy(&server->lock);
+}
+
+#endif // MOCK_WS_SERVER_H
\ No newline at end of file
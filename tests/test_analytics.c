@@ -0,0 +1,146 @@
+#include "analytics.h"
+#include "test_util.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int updates = 0;
+
+static void count_update(void *user, const analytics_snapshot_t *snapshot) {
+    (void)user;
+    (void)snapshot;
+    updates++;
+}
+
+static void trade(analytics_t *engine, const char *symbol, int64_t ts, double price, double qty,
+                  bool buyer_maker) {
+    market_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.event = MARKET_EVENT_AGG_TRADE;
+    data.symbol = (char *)symbol;
+    data.timestamp = ts;
+    data.price = price;
+    data.quantity = qty;
+    data.is_buyer_maker = buyer_maker;
+    analytics_update(engine, &data);
+}
+
+// A busy symbol keeps the whole time window past the initial ring size
+static void test_window_grows(void) {
+    analytics_t *engine = analytics_create(60000, 100, NULL, NULL);
+    CHECK(engine != NULL);
+
+    int trades = ANALYTICS_WINDOW_INITIAL_CAPACITY * 10;
+    for (int i = 0; i < trades; i++) {
+        trade(engine, "BTCUSDT", 1000 + i, (i & 1) ? 101.0 : 99.0, 1.0, false);
+    }
+
+    analytics_snapshot_t snapshot;
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == 0);
+    CHECK(snapshot.window_trades == (uint32_t)trades);
+    CHECK(snapshot.window_overflows == 0);
+    CHECK(fabs(snapshot.vwap - 100.0) < 1e-9);
+    CHECK(fabs(snapshot.vwap_count - 100.0) < 1e-9);
+    CHECK(fabs(snapshot.trade_imbalance - 1.0) < 1e-9);
+    analytics_destroy(engine);
+}
+
+// Past the size limit the oldest trades leave early and are counted
+static void test_window_overflow(void) {
+    analytics_t *engine = analytics_create(3600000, 10, NULL, NULL);
+    CHECK(engine != NULL);
+
+    int extra = 1000;
+    for (int i = 0; i < ANALYTICS_WINDOW_MAX_CAPACITY + extra; i++) {
+        // Trades in the first half sell, the rest buy
+        trade(engine, "ETHUSDT", 1000, 2000.0, 1.0, i < extra);
+    }
+
+    analytics_snapshot_t snapshot;
+    CHECK(analytics_snapshot(engine, "ETHUSDT", &snapshot) == 0);
+    CHECK(snapshot.window_trades == ANALYTICS_WINDOW_MAX_CAPACITY);
+    CHECK(snapshot.window_overflows == (uint64_t)extra);
+    // Only buys are left after the sells were pushed out
+    CHECK(fabs(snapshot.trade_imbalance - 1.0) < 1e-9);
+    analytics_destroy(engine);
+}
+
+// Quiet symbols age out without new trades
+static void test_expire(void) {
+    updates = 0;
+    analytics_t *engine = analytics_create(1000, 100, count_update, NULL);
+    CHECK(engine != NULL);
+
+    trade(engine, "BTCUSDT", 10000, 100.0, 1.0, false);
+    trade(engine, "BTCUSDT", 10500, 110.0, 1.0, false);
+    trade(engine, "ETHUSDT", 10900, 2000.0, 1.0, false);
+    CHECK(updates == 3);
+
+    analytics_expire(engine, 10999);
+    CHECK(updates == 3);
+
+    analytics_snapshot_t snapshot;
+    analytics_expire(engine, 11000);
+    CHECK(updates == 4);
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == 0);
+    CHECK(snapshot.window_trades == 1);
+    CHECK(fabs(snapshot.vwap - 110.0) < 1e-9);
+
+    analytics_expire(engine, 12000);
+    CHECK(updates == 6);
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == 0);
+    CHECK(snapshot.window_trades == 0);
+    CHECK(snapshot.vwap == 0.0 && snapshot.realized_vol == 0.0);
+    // The count window is not time based
+    CHECK(fabs(snapshot.vwap_count - 105.0) < 1e-9);
+    analytics_destroy(engine);
+}
+
+// Book imbalance only comes from a book, not from depth diffs
+static void test_book_imbalance(void) {
+    analytics_t *engine = analytics_create(1000, 100, NULL, NULL);
+    CHECK(engine != NULL);
+
+    double bid_px[] = { 100.0, 99.0 }, bid_qty[] = { 3.0, 2.0 };
+    double ask_px[] = { 101.0, 102.0 }, ask_qty[] = { 2.0, 3.0 };
+    market_data_t diff;
+    memset(&diff, 0, sizeof(diff));
+    diff.event = MARKET_EVENT_DEPTH;
+    diff.symbol = "BTCUSDT";
+    diff.bid_prices = bid_px;
+    diff.bid_quantities = bid_qty;
+    diff.bid_count = 2;
+    diff.ask_prices = ask_px;
+    diff.ask_quantities = ask_qty;
+    diff.ask_count = 1;
+    analytics_update(engine, &diff);
+
+    analytics_snapshot_t snapshot;
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == -1);
+
+    order_book_t book;
+    memset(&book, 0, sizeof(book));
+    CHECK(order_book_load(&book, bid_px, bid_qty, 2, ask_px, ask_qty, 2, 1) == 0);
+    analytics_update_book(engine, "BTCUSDT", NULL, 5);
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == -1);
+    analytics_update_book(engine, "BTCUSDT", &book, 5);
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == 0);
+    CHECK(fabs(snapshot.book_imbalance) < 1e-9);
+
+    CHECK(order_book_set(&book, true, 98.0, 5.0) == 0);
+    analytics_update_book(engine, "BTCUSDT", &book, 6);
+    CHECK(analytics_snapshot(engine, "BTCUSDT", &snapshot) == 0);
+    CHECK(fabs(snapshot.book_imbalance - 1.0 / 3.0) < 1e-9);
+    CHECK(snapshot.timestamp == 6);
+
+    order_book_free(&book);
+    analytics_destroy(engine);
+}
+
+int main(void) {
+    test_window_grows();
+    test_window_overflow();
+    test_expire();
+    test_book_imbalance();
+    return TEST_RESULT();
+}
\ No newline at end of file
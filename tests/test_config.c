@@ -0,0 +1,135 @@
+#include "config.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Write contents to a temporary config file, path in path (PATH_MAX sized)
+static int write_config(char *path, const char *contents) {
+    strcpy(path, "/tmp/cryptostream_config_XXXXXX");
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t len = strlen(contents);
+    int result = write(fd, contents, len) == (ssize_t)len ? 0 : -1;
+    close(fd);
+    return result;
+}
+
+static void test_streams_and_sink(void) {
+    char path[64];
+    CHECK(write_config(path,
+                       "# comment\n"
+                       "\n"
+                       "stream=btcusdt@aggTrade\n"
+                       "streams=ethusdt@markPrice,btcusdt@aggTrade,btcusdt@depth@100ms\n"
+                       "sink=store\n"
+                       "store_dir=/tmp/ticks\n"
+                       "so_rcvbuf=1048576\n"
+                       "tcp_quickack=true\n"
+                       "event_merge=1\n") == 0);
+
+    app_config_t config;
+    config_init(&config);
+    CHECK(config.sink == SINK_STDOUT);
+    CHECK(config_load_file(path, &config) == 0);
+
+    // Duplicates across stream= and streams= are kept once, in first seen order
+    CHECK(config.stream_count == 3);
+    CHECK(strcmp(config.streams[0], "btcusdt@aggTrade") == 0);
+    CHECK(strcmp(config.streams[1], "ethusdt@markPrice") == 0);
+    CHECK(strcmp(config.streams[2], "btcusdt@depth@100ms") == 0);
+
+    CHECK(config.sink == SINK_STORE);
+    CHECK(strcmp(config.store_dir, "/tmp/ticks") == 0);
+    CHECK(config.socket.rcvbuf == 1048576);
+    CHECK(config.socket.tcp_quickack);
+    CHECK(!config.socket.tcp_nodelay);
+    CHECK(config.event_merge);
+
+    config_free(&config);
+    unlink(path);
+}
+
+// An unknown sink name leaves the previous sink in place
+static void test_unknown_sink(void) {
+    char path[64];
+    CHECK(write_config(path, "sink=none\nsink=kafka\n") == 0);
+
+    app_config_t config;
+    config_init(&config);
+    CHECK(config_load_file(path, &config) == 0);
+    CHECK(config.sink == SINK_NONE);
+
+    sink_type_t sink = SINK_STORE;
+    CHECK(config_parse_sink("kafka", &sink) == -1);
+    CHECK(sink == SINK_STORE);
+    CHECK(config_parse_sink("stdout", &sink) == 0);
+    CHECK(sink == SINK_STDOUT);
+
+    CHECK(config_load_file("/nonexistent/cryptostream.conf", &config) == -1);
+    config_free(&config);
+    unlink(path);
+}
+
+static void test_stream_limit(void) {
+    app_config_t config;
+    config_init(&config);
+
+    char stream[32];
+    for (int i = 0; i < CONFIG_MAX_STREAMS; i++) {
+        snprintf(stream, sizeof(stream), "sym%d@aggTrade", i);
+        CHECK(config_add_stream(&config, stream) == 0);
+    }
+    CHECK(config.stream_count == CONFIG_MAX_STREAMS);
+    CHECK(config_add_stream(&config, "sym0@aggTrade") == 0);
+    CHECK(config_add_stream(&config, "one@toomany") == -1);
+    CHECK(config_add_stream(&config, "") == -1);
+    CHECK(config.stream_count == CONFIG_MAX_STREAMS);
+
+    config_free(&config);
+}
+
+// Reload applies streams and sink in place, everything else waits for a restart
+static void test_reload_diff(void) {
+    app_config_t current, next;
+    config_init(&current);
+    config_init(&next);
+    config_add_stream(&current, "btcusdt@aggTrade");
+    CHECK(!config_needs_restart(&current, &next));
+
+    config_add_stream(&next, "ethusdt@aggTrade");
+    next.sink = SINK_NONE;
+    next.parser_check = true;
+    next.metrics_log_interval = 10;
+    CHECK(!config_needs_restart(&current, &next));
+
+    next.socket.tcp_nodelay = true;
+    CHECK(config_needs_restart(&current, &next));
+    next.socket.tcp_nodelay = false;
+
+    next.rest_port = 8443;
+    CHECK(config_needs_restart(&current, &next));
+    next.rest_port = current.rest_port;
+
+    free(next.proxy_address);
+    next.proxy_address = strdup("10.0.0.1");
+    CHECK(config_needs_restart(&current, &next));
+    free(next.proxy_address);
+    next.proxy_address = NULL;
+
+    next.merge_max_lateness_ms = 5;
+    CHECK(config_needs_restart(&current, &next));
+
+    config_free(&current);
+    config_free(&next);
+}
+
+int main(void) {
+    test_streams_and_sink();
+    test_unknown_sink();
+    test_stream_limit();
+    test_reload_diff();
+    return TEST_RESULT();
+}
\ No newline at end of file
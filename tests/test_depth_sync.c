@@ -0,0 +1,249 @@
+#include "depth_sync.h"
+#include "mock_http_server.h"
+#include "test_util.h"
+
+static mock_http_server_t server;
+
+static struct lws_context* create_context(void) {
+    struct lws_context_creation_info info;
+    memset(&info, 0, sizeof(info));
+    info.port = CONTEXT_PORT_NO_LISTEN;
+    return lws_create_context(&info);
+}
+
+static depth_sync_t* create_sync(struct lws_context *context) {
+    return depth_sync_create(context, "127.0.0.1", server.port, false, 1000, 10, 100000);
+}
+
+static const depth_symbol_t* entry_of(const depth_sync_t *sync, const char *symbol) {
+    for (int i = 0; i < DEPTH_SYNC_MAX_SYMBOLS; i++) {
+        if (sync->symbols[i] && strcmp(sync->symbols[i]->symbol, symbol) == 0) {
+            return sync->symbols[i];
+        }
+    }
+    return NULL;
+}
+
+// Pump and service until symbol reaches state, false after two seconds
+static bool service_until(struct lws_context *context, depth_sync_t *sync, const char *symbol,
+                          book_state_t state) {
+    for (int i = 0; i < 200; i++) {
+        const depth_symbol_t *entry = entry_of(sync, symbol);
+        if (entry && entry->state == state) {
+            return true;
+        }
+        depth_sync_pump(sync);
+        lws_service(context, 10);
+    }
+    return false;
+}
+
+static void diff(depth_sync_t *sync, const char *symbol, long first, long final, long prev,
+                 double bid_price, double bid_quantity) {
+    market_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.event = MARKET_EVENT_DEPTH;
+    data.symbol = (char *)symbol;
+    data.first_update_id = first;
+    data.final_update_id = final;
+    data.prev_final_update_id = prev;
+    data.bid_prices = &bid_price;
+    data.bid_quantities = &bid_quantity;
+    data.bid_count = 1;
+    depth_sync_update(sync, &data);
+}
+
+// A snapshot alone is not served: only a diff straddling it shows it is current
+static void test_snapshot_waits_for_diff(void) {
+    struct lws_context *context = create_context();
+    depth_sync_t *sync = create_sync(context);
+    CHECK(sync != NULL);
+
+    CHECK(depth_sync_track(sync, "BTCUSDT") == 0);
+    CHECK(service_until(context, sync, "BTCUSDT", BOOK_SNAPSHOT));
+    CHECK(depth_sync_book(sync, "BTCUSDT") == NULL);
+    CHECK(sync->live_count == 0);
+
+    // Entirely before the snapshot: still not live
+    diff(sync, "BTCUSDT", 90, 99, 89, 100.0, 5.0);
+    CHECK(depth_sync_book(sync, "BTCUSDT") == NULL);
+
+    diff(sync, "BTCUSDT", 95, 105, 99, 100.0, 3.0);
+    const order_book_t *book = depth_sync_book(sync, "BTCUSDT");
+    CHECK(book != NULL);
+    CHECK(sync->live_count == 1);
+    double price = 0.0, quantity = 0.0;
+    CHECK(book && order_book_best_bid(book, &price, &quantity));
+    CHECK(price == 100.0 && quantity == 3.0);
+    CHECK(book && book->last_update_id == 105);
+
+    diff(sync, "BTCUSDT", 106, 110, 105, 99.99, 0.0);
+    CHECK(book && book->last_update_id == 110);
+    CHECK(entry_of(sync, "BTCUSDT")->diffs_applied == 2);
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+}
+
+// Diffs buffered during the fetch are replayed and confirm the snapshot
+static void test_buffered_diffs(void) {
+    struct lws_context *context = create_context();
+    depth_sync_t *sync = create_sync(context);
+
+    CHECK(depth_sync_track(sync, "ETHUSDT") == 0);
+    diff(sync, "ETHUSDT", 90, 99, 89, 100.0, 5.0);
+    diff(sync, "ETHUSDT", 99, 104, 99, 100.0, 4.0);
+    CHECK(service_until(context, sync, "ETHUSDT", BOOK_LIVE));
+    const order_book_t *book = depth_sync_book(sync, "ETHUSDT");
+    CHECK(book && book->last_update_id == 104);
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+}
+
+// A gap reported upstream drops the live book and starts over from a new snapshot
+static void test_resync_after_gap(void) {
+    struct lws_context *context = create_context();
+    depth_sync_t *sync = create_sync(context);
+
+    CHECK(depth_sync_track(sync, "BTCUSDT") == 0);
+    diff(sync, "BTCUSDT", 99, 101, 98, 100.0, 1.0);
+    CHECK(service_until(context, sync, "BTCUSDT", BOOK_LIVE));
+    CHECK(sync->live_count == 1);
+
+    CHECK(depth_sync_resync(sync, "BTCUSDT") == 0);
+    CHECK(depth_sync_book(sync, "BTCUSDT") == NULL);
+    CHECK(sync->live_count == 0);
+    CHECK(entry_of(sync, "BTCUSDT")->resyncs == 1);
+    CHECK(entry_of(sync, "BTCUSDT")->state == BOOK_WAIT_SNAPSHOT);
+    CHECK(depth_sync_resync(sync, "ETHUSDT") == -1);
+
+    // Diffs after the gap are buffered and continue the next snapshot
+    diff(sync, "BTCUSDT", 99, 102, 101, 100.0, 2.0);
+    CHECK(service_until(context, sync, "BTCUSDT", BOOK_LIVE));
+    const order_book_t *book = depth_sync_book(sync, "BTCUSDT");
+    CHECK(book && book->last_update_id == 102);
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+}
+
+// A refused connection fails the request once and frees it, the book waits for a retry
+static void test_refused_snapshot(void) {
+    struct lws_context *context = create_context();
+    // Bound but never listening, so the connect is refused
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr *)&addr, &addr_len);
+    depth_sync_t *sync = depth_sync_create(context, "127.0.0.1", ntohs(addr.sin_port), false,
+                                           1000, 10, 100000);
+
+    CHECK(depth_sync_track(sync, "BTCUSDT") == 0);
+    depth_sync_pump(sync);
+    for (int i = 0; i < 10; i++) {
+        lws_service(context, 10);
+    }
+    const depth_symbol_t *entry = entry_of(sync, "BTCUSDT");
+    CHECK(entry && entry->state == BOOK_WAIT_SNAPSHOT && entry->retry_at_ns > 0);
+    CHECK(sync->fetcher->in_flight == 0);
+    CHECK(sync->fetcher->requests == NULL);
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+    close(fd);
+}
+
+// Symbols dropped from the stream set lose their book and their snapshot request
+static void test_untrack_streams(void) {
+    struct lws_context *context = create_context();
+    depth_sync_t *sync = create_sync(context);
+
+    const char *all[] = { "btcusdt@depth", "ethusdt@depth@100ms", "btcusdt@aggTrade" };
+    depth_sync_track_streams(sync, all, 3);
+    CHECK(sync->symbol_count == 2);
+    diff(sync, "BTCUSDT", 99, 101, 98, 100.0, 1.0);
+    CHECK(service_until(context, sync, "BTCUSDT", BOOK_LIVE));
+    CHECK(service_until(context, sync, "ETHUSDT", BOOK_SNAPSHOT));
+
+    // Request in flight for SOLUSDT when it is removed again
+    const char *with_sol[] = { "btcusdt@depth", "ethusdt@depth@100ms", "solusdt@depth" };
+    depth_sync_track_streams(sync, with_sol, 3);
+    depth_sync_pump(sync);
+    CHECK(entry_of(sync, "SOLUSDT") && entry_of(sync, "SOLUSDT")->state == BOOK_FETCHING);
+
+    const char *eth_only[] = { "ethusdt@depth@100ms" };
+    depth_sync_track_streams(sync, eth_only, 1);
+    CHECK(sync->symbol_count == 1);
+    CHECK(sync->live_count == 0);
+    CHECK(entry_of(sync, "BTCUSDT") == NULL && entry_of(sync, "SOLUSDT") == NULL);
+    CHECK(depth_sync_book(sync, "BTCUSDT") == NULL);
+
+    for (int i = 0; i < 50 && sync->fetcher->in_flight > 0; i++) {
+        lws_service(context, 10);
+    }
+    CHECK(sync->fetcher->in_flight == 0);
+    CHECK(sync->fetcher->requests == NULL);
+
+    // Tracked again, the symbol starts over with its own request
+    depth_sync_track_streams(sync, with_sol, 3);
+    CHECK(sync->symbol_count == 3);
+    CHECK(entry_of(sync, "SOLUSDT")->state == BOOK_WAIT_SNAPSHOT);
+    CHECK(service_until(context, sync, "SOLUSDT", BOOK_SNAPSHOT));
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+}
+
+// Removal keeps every remaining symbol reachable along its probe run
+static void test_removal_keeps_lookups(void) {
+    struct lws_context *context = create_context();
+    depth_sync_t *sync = create_sync(context);
+
+    char symbol[DEPTH_SYNC_SYMBOL_SIZE];
+    int tracked = 400;
+    for (int i = 0; i < tracked; i++) {
+        snprintf(symbol, sizeof(symbol), "SYM%dUSDT", i);
+        CHECK(depth_sync_track(sync, symbol) == 0);
+    }
+    for (int i = 0; i < tracked; i += 2) {
+        snprintf(symbol, sizeof(symbol), "SYM%dUSDT", i);
+        CHECK(depth_sync_untrack(sync, symbol) == 0);
+    }
+    CHECK(sync->symbol_count == tracked / 2);
+
+    // Tracking a present symbol finds it instead of inserting a duplicate
+    for (int i = 0; i < tracked; i++) {
+        snprintf(symbol, sizeof(symbol), "SYM%dUSDT", i);
+        if (i % 2) {
+            CHECK(depth_sync_track(sync, symbol) == 0);
+        } else {
+            CHECK(depth_sync_untrack(sync, symbol) == -1);
+        }
+    }
+    CHECK(sync->symbol_count == tracked / 2);
+
+    lws_context_destroy(context);
+    depth_sync_destroy(sync);
+}
+
+int main(void) {
+    if (mock_http_start(&server, 20, 100) < 0) {
+        fprintf(stderr, "Cannot listen on loopback\n");
+        return 1;
+    }
+
+    test_snapshot_waits_for_diff();
+    test_buffered_diffs();
+    test_resync_after_gap();
+    test_refused_snapshot();
+    test_untrack_streams();
+    test_removal_keeps_lookups();
+
+    mock_http_stop(&server);
+    return TEST_RESULT();
+}
\ No newline at end of file
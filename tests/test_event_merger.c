@@ -0,0 +1,191 @@
+#include "event_merger.h"
+#include "metrics.h"
+#include "socket_tuning.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MS 1000000LL
+#define MAX_RELEASED 64
+
+typedef struct {
+    char symbol[16];
+    long event_ms;
+    bool late;
+} released_t;
+
+static released_t released[MAX_RELEASED];
+static int released_count = 0;
+
+static void on_event(void *user, const market_data_t *data, bool late) {
+    (void)user;
+    if (released_count < MAX_RELEASED) {
+        released_t *entry = &released[released_count];
+        snprintf(entry->symbol, sizeof(entry->symbol), "%s", data->symbol ? data->symbol : "");
+        entry->event_ms = data->event_time ? data->event_time : data->timestamp;
+        entry->late = late;
+    }
+    released_count++;
+}
+
+// Heap allocated like the parser's output, the merger takes ownership
+static market_data_t* event(const char *symbol, long event_ms) {
+    market_data_t *data = (market_data_t *)calloc(1, sizeof(market_data_t));
+    data->event = MARKET_EVENT_AGG_TRADE;
+    data->symbol = strdup(symbol);
+    data->event_time = event_ms;
+    return data;
+}
+
+static bool released_is(int index, const char *symbol, long event_ms, bool late) {
+    if (index >= released_count) {
+        fprintf(stderr, "release %d missing\n", index);
+        return false;
+    }
+    const released_t *entry = &released[index];
+    bool same = strcmp(entry->symbol, symbol) == 0 && entry->event_ms == event_ms &&
+                entry->late == late;
+    if (!same) {
+        fprintf(stderr, "release %d: %s %ld%s, expected %s %ld%s\n", index, entry->symbol,
+                entry->event_ms, entry->late ? " late" : "", symbol, event_ms, late ? " late" : "");
+    }
+    return same;
+}
+
+// Events of several streams come out by exchange time, equal times in arrival order
+static void test_order_across_streams(void) {
+    event_merger_t *merger = event_merger_create(20, 0, 16, on_event, NULL);
+    released_count = 0;
+
+    event_merger_push(merger, event("BTCUSDT", 1005), 0);
+    event_merger_push(merger, event("ETHUSDT", 1000), 0);
+    event_merger_push(merger, event("SOLUSDT", 1005), 0);
+    event_merger_push(merger, event("BNBUSDT", 1003), 0);
+    CHECK(released_count == 0);
+
+    // 1030 covers the window for everything up to 1010
+    event_merger_push(merger, event("BTCUSDT", 1030), 0);
+    CHECK(released_count == 4);
+    CHECK(released_is(0, "ETHUSDT", 1000, false));
+    CHECK(released_is(1, "BNBUSDT", 1003, false));
+    CHECK(released_is(2, "BTCUSDT", 1005, false));
+    CHECK(released_is(3, "SOLUSDT", 1005, false));
+
+    event_merger_destroy(merger);
+}
+
+// Without newer events an event goes once it has waited the window locally
+static void test_local_time_window(void) {
+    event_merger_t *merger = event_merger_create(20, 0, 16, on_event, NULL);
+    released_count = 0;
+
+    event_merger_push(merger, event("BTCUSDT", 2000), 5 * MS);
+    event_merger_drain(merger, 24 * MS);
+    CHECK(released_count == 0);
+    event_merger_drain(merger, 25 * MS);
+    CHECK(released_count == 1);
+    CHECK(released_is(0, "BTCUSDT", 2000, false));
+
+    // Events without exchange time pass straight through
+    market_data_t *untimed = event("ETHUSDT", 0);
+    event_merger_push(merger, untimed, 30 * MS);
+    CHECK(released_count == 2);
+    CHECK(released_is(1, "ETHUSDT", 0, false));
+
+    event_merger_destroy(merger);
+}
+
+// Behind the watermark: released marked late within the bound, dropped and counted beyond it
+static void test_lateness(void) {
+    event_merger_t *merger = event_merger_create(20, 5, 16, on_event, NULL);
+    released_count = 0;
+    uint64_t late_before = metrics_counter_value(METRIC_LATE_EVENTS);
+    uint64_t drops_before = metrics_counter_value(METRIC_LATE_DROPS);
+
+    event_merger_push(merger, event("BTCUSDT", 1030), 0);
+    event_merger_drain(merger, 20 * MS);
+    CHECK(released_count == 1);
+
+    event_merger_push(merger, event("ETHUSDT", 1027), 21 * MS);
+    CHECK(released_count == 2);
+    CHECK(released_is(1, "ETHUSDT", 1027, true));
+
+    event_merger_push(merger, event("SOLUSDT", 1020), 22 * MS);
+    CHECK(released_count == 2);
+
+    // The watermark stays at the newest in-order release
+    event_merger_push(merger, event("BNBUSDT", 1025), 23 * MS);
+    CHECK(released_is(2, "BNBUSDT", 1025, true));
+
+    CHECK(metrics_counter_value(METRIC_LATE_EVENTS) - late_before == 2);
+    CHECK(metrics_counter_value(METRIC_LATE_DROPS) - drops_before == 1);
+
+    event_merger_destroy(merger);
+}
+
+// A full window releases its oldest event early, flush empties the rest in order
+static void test_forced_and_flush(void) {
+    event_merger_t *merger = event_merger_create(20, 0, 4, on_event, NULL);
+    released_count = 0;
+    uint64_t forced_before = metrics_counter_value(METRIC_MERGE_FORCED);
+
+    event_merger_push(merger, event("BTCUSDT", 103), 0);
+    event_merger_push(merger, event("ETHUSDT", 101), 0);
+    event_merger_push(merger, event("SOLUSDT", 100), 0);
+    event_merger_push(merger, event("BNBUSDT", 102), 0);
+    CHECK(released_count == 0);
+
+    event_merger_push(merger, event("XRPUSDT", 104), 0);
+    CHECK(released_count == 1);
+    CHECK(released_is(0, "SOLUSDT", 100, false));
+    CHECK(metrics_counter_value(METRIC_MERGE_FORCED) - forced_before == 1);
+
+    event_merger_flush(merger);
+    CHECK(released_count == 5);
+    CHECK(released_is(1, "ETHUSDT", 101, false));
+    CHECK(released_is(2, "BNBUSDT", 102, false));
+    CHECK(released_is(3, "BTCUSDT", 103, false));
+    CHECK(released_is(4, "XRPUSDT", 104, false));
+
+    // Held events are freed with the merger
+    event_merger_push(merger, event("BTCUSDT", 200), 0);
+    event_merger_destroy(merger);
+    CHECK(released_count == 5);
+}
+
+// A stamp far ahead of the local clock is dropped instead of moving the watermark
+static void test_future_event(void) {
+    event_merger_t *merger = event_merger_create(20, 0, 16, on_event, NULL);
+    released_count = 0;
+    uint64_t drops_before = metrics_counter_value(METRIC_FUTURE_DROPS);
+    long now_ms = (long)(socket_tuning_now_ns() / MS);
+
+    event_merger_push(merger, event("BTCUSDT", now_ms + 3600 * 1000), 0);
+    CHECK(metrics_counter_value(METRIC_FUTURE_DROPS) - drops_before == 1);
+
+    // The receive time is the reference when the event carries one
+    market_data_t *stamped = event("ETHUSDT", 5000 + EVENT_MERGER_MAX_AHEAD_MS + 1);
+    stamped->receive_time_ns = 5000 * MS;
+    event_merger_push(merger, stamped, 0);
+    CHECK(metrics_counter_value(METRIC_FUTURE_DROPS) - drops_before == 2);
+
+    // Later events are still ordered as usual
+    event_merger_push(merger, event("SOLUSDT", now_ms), 0);
+    event_merger_push(merger, event("BNBUSDT", now_ms - 1), 0);
+    event_merger_flush(merger);
+    CHECK(released_count == 2);
+    CHECK(released_is(0, "BNBUSDT", now_ms - 1, false));
+    CHECK(released_is(1, "SOLUSDT", now_ms, false));
+
+    event_merger_destroy(merger);
+}
+
+int main(void) {
+    test_order_across_streams();
+    test_local_time_window();
+    test_lateness();
+    test_forced_and_flush();
+    test_future_event();
+    metrics_shutdown();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "metrics.h"
+#include "test_util.h"
+#include <pthread.h>
+
+static atomic_bool recording = true;
+static atomic_bool started = false;
+
+static void *record_until_stopped(void *arg) {
+    (void)arg;
+    metrics_inc(METRIC_MESSAGES_RECEIVED);
+    atomic_store(&started, true);
+    while (atomic_load(&recording)) {
+        metrics_inc(METRIC_MESSAGES_RECEIVED);
+        metrics_record_stream("BTCUSDT", MARKET_EVENT_AGG_TRADE, 100);
+    }
+    return NULL;
+}
+
+static void *record_once(void *arg) {
+    (void)arg;
+    metrics_add(METRIC_BYTES_RECEIVED, 10);
+    return NULL;
+}
+
+// Counts from exited threads stay in the totals
+static void test_exited_thread_counts(void) {
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, record_once, NULL) == 0);
+    pthread_join(thread, NULL);
+    metrics_add(METRIC_BYTES_RECEIVED, 5);
+    CHECK(metrics_counter_value(METRIC_BYTES_RECEIVED) == 15);
+}
+
+// Shutdown while another thread records: its shard stays valid and keeps counting
+static void test_shutdown_with_running_thread(void) {
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, record_until_stopped, NULL) == 0);
+    while (!atomic_load(&started)) {
+    }
+
+    metrics_shutdown();
+    CHECK(metrics_counter_value(METRIC_BYTES_RECEIVED) == 0);
+
+    uint64_t before = metrics_counter_value(METRIC_MESSAGES_RECEIVED);
+    while (metrics_counter_value(METRIC_MESSAGES_RECEIVED) == before) {
+    }
+    atomic_store(&recording, false);
+    pthread_join(thread, NULL);
+    CHECK(metrics_counter_value(METRIC_MESSAGES_RECEIVED) > before);
+
+    // The calling thread attaches a fresh shard after shutdown
+    metrics_inc(METRIC_CONNECTS);
+    CHECK(metrics_counter_value(METRIC_CONNECTS) == 1);
+    metrics_shutdown();
+    CHECK(metrics_counter_value(METRIC_MESSAGES_RECEIVED) == 0);
+}
+
+int main(void) {
+    test_exited_thread_counts();
+    test_shutdown_with_running_thread();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "send_queue.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRODUCERS 4
+#define MESSAGES_PER_PRODUCER 50000
+#define HEADROOM 16
+
+typedef struct {
+    int producer;
+    int index;
+} message_t;
+
+typedef struct {
+    send_queue_t *queue;
+    int producer;
+    long full;
+} producer_t;
+
+static void* produce(void *arg) {
+    producer_t *producer = (producer_t *)arg;
+    for (int i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+        message_t message = { producer->producer, i };
+        while (send_queue_push(producer->queue, &message, sizeof(message)) < 0) {
+            producer->full++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Several producers, one consumer: every message arrives once, in order per producer
+static void test_concurrent_producers(void) {
+    send_queue_t *queue = send_queue_create(64, HEADROOM);
+    CHECK(queue != NULL);
+
+    producer_t producers[PRODUCERS];
+    pthread_t threads[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers[p] = (producer_t){ queue, p, 0 };
+        pthread_create(&threads[p], NULL, produce, &producers[p]);
+    }
+
+    int next[PRODUCERS] = {0};
+    long received = 0, out_of_order = 0, bad = 0;
+    while (received < (long)PRODUCERS * MESSAGES_PER_PRODUCER) {
+        size_t len = 0;
+        unsigned char *data = send_queue_peek(queue, &len);
+        if (!data) {
+            sched_yield();
+            continue;
+        }
+        message_t message;
+        memcpy(&message, data, sizeof(message));
+        if (len != sizeof(message) || message.producer < 0 || message.producer >= PRODUCERS) {
+            bad++;
+        } else if (message.index != next[message.producer]++) {
+            out_of_order++;
+        }
+        send_queue_pop(queue);
+        received++;
+    }
+
+    long full = 0;
+    for (int p = 0; p < PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+        CHECK(next[p] == MESSAGES_PER_PRODUCER);
+        full += producers[p].full;
+    }
+    CHECK(bad == 0);
+    CHECK(out_of_order == 0);
+    CHECK(send_queue_peek(queue, NULL) == NULL);
+    CHECK(send_queue_depth(queue) == 0);
+    printf("%ld messages, %ld pushes rejected while full\n", received, full);
+
+    send_queue_destroy(queue);
+}
+
+// A full queue rejects pushes until the consumer frees a slot
+static void test_full_queue(void) {
+    send_queue_t *queue = send_queue_create(3, HEADROOM);
+    CHECK(queue && queue->capacity == 4);
+
+    for (int i = 0; i < 4; i++) {
+        CHECK(send_queue_push(queue, &i, sizeof(i)) == 0);
+    }
+    int extra = 4;
+    CHECK(send_queue_push(queue, &extra, sizeof(extra)) == -1);
+    CHECK(send_queue_depth(queue) == 4);
+
+    send_queue_pop(queue);
+    CHECK(send_queue_push(queue, &extra, sizeof(extra)) == 0);
+    CHECK(send_queue_push(queue, &extra, sizeof(extra)) == -1);
+
+    send_queue_destroy(queue);
+}
+
+// Positions wrap around the slots many times with contents intact
+static void test_wrap_around(void) {
+    send_queue_t *queue = send_queue_create(4, HEADROOM);
+
+    int pushed = 0, popped = 0;
+    for (int lap = 0; lap < 100; lap++) {
+        for (int i = 0; i < 3; i++, pushed++) {
+            CHECK(send_queue_push(queue, &pushed, sizeof(pushed)) == 0);
+        }
+        for (int i = 0; i < 3; i++, popped++) {
+            size_t len = 0;
+            unsigned char *data = send_queue_peek(queue, &len);
+            int value = -1;
+            if (data) {
+                memcpy(&value, data, sizeof(value));
+            }
+            CHECK(len == sizeof(int) && value == popped);
+            send_queue_pop(queue);
+        }
+    }
+    CHECK(send_queue_depth(queue) == 0);
+
+    send_queue_destroy(queue);
+}
+
+// Up to SEND_QUEUE_MESSAGE_SIZE fits, anything larger is refused
+static void test_message_size(void) {
+    send_queue_t *queue = send_queue_create(4, HEADROOM);
+    unsigned char *large = (unsigned char *)malloc(SEND_QUEUE_MESSAGE_SIZE + 1);
+    memset(large, 'x', SEND_QUEUE_MESSAGE_SIZE + 1);
+    large[SEND_QUEUE_MESSAGE_SIZE - 1] = 'y';
+
+    CHECK(send_queue_push(queue, large, SEND_QUEUE_MESSAGE_SIZE + 1) == -1);
+    CHECK(send_queue_depth(queue) == 0);
+    CHECK(send_queue_push(queue, large, SEND_QUEUE_MESSAGE_SIZE) == 0);
+    CHECK(send_queue_push(queue, "", 0) == 0);
+
+    size_t len = 0;
+    unsigned char *data = send_queue_peek(queue, &len);
+    CHECK(data && len == SEND_QUEUE_MESSAGE_SIZE);
+    CHECK(data && memcmp(data, large, SEND_QUEUE_MESSAGE_SIZE) == 0);
+    send_queue_pop(queue);
+    data = send_queue_peek(queue, &len);
+    CHECK(data && len == 0);
+
+    free(large);
+    send_queue_destroy(queue);
+}
+
+// The headroom in front of a peeked message is writable without touching its neighbours
+static void test_peek_pop_clear(void) {
+    send_queue_t *queue = send_queue_create(4, HEADROOM);
+    CHECK(send_queue_peek(queue, NULL) == NULL);
+    send_queue_pop(queue);
+    CHECK(send_queue_depth(queue) == 0);
+
+    CHECK(send_queue_push(queue, "first", 5) == 0);
+    CHECK(send_queue_push(queue, "second", 6) == 0);
+
+    size_t len = 0;
+    unsigned char *data = send_queue_peek(queue, &len);
+    CHECK(data && len == 5 && memcmp(data, "first", 5) == 0);
+    CHECK(data && (size_t)(data - queue->slots) % queue->stride == HEADROOM);
+    CHECK(queue->stride >= HEADROOM + SEND_QUEUE_MESSAGE_SIZE);
+
+    // Peeking again returns the same message until it is popped
+    CHECK(send_queue_peek(queue, NULL) == data);
+    if (data) {
+        memset(data - HEADROOM, 0xaa, HEADROOM);
+    }
+    send_queue_pop(queue);
+
+    data = send_queue_peek(queue, &len);
+    CHECK(data && len == 6 && memcmp(data, "second", 6) == 0);
+    if (data) {
+        memset(data - HEADROOM, 0xaa, HEADROOM);
+        CHECK(memcmp(data, "second", 6) == 0);
+    }
+
+    CHECK(send_queue_push(queue, "third", 5) == 0);
+    send_queue_clear(queue);
+    CHECK(send_queue_peek(queue, NULL) == NULL);
+    CHECK(send_queue_depth(queue) == 0);
+
+    // Usable again after clearing
+    CHECK(send_queue_push(queue, "fourth", 6) == 0);
+    data = send_queue_peek(queue, &len);
+    CHECK(data && len == 6 && memcmp(data, "fourth", 6) == 0);
+
+    send_queue_destroy(queue);
+}
+
+int main(void) {
+    test_full_queue();
+    test_wrap_around();
+    test_message_size();
+    test_peek_pop_clear();
+    test_concurrent_producers();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "sequence.h"
+#include "test_util.h"
+#include <string.h>
+
+static seq_event_t last_event;
+static int event_count = 0;
+
+static void on_event(void *user, const seq_event_t *event) {
+    (void)user;
+    last_event = *event;
+    event_count++;
+}
+
+static seq_status_t agg_trade(seq_tracker_t *tracker, const char *symbol, long id, long first,
+                              long last) {
+    market_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.event = MARKET_EVENT_AGG_TRADE;
+    data.symbol = (char *)symbol;
+    data.agg_trade_id = id;
+    data.first_trade_id = first;
+    data.last_trade_id = last;
+    return seq_tracker_check(tracker, &data);
+}
+
+static seq_status_t book_ticker(seq_tracker_t *tracker, const char *symbol, long update_id) {
+    market_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.event = MARKET_EVENT_BOOK_TICKER;
+    data.symbol = (char *)symbol;
+    data.final_update_id = update_id;
+    return seq_tracker_check(tracker, &data);
+}
+
+static seq_status_t depth(seq_tracker_t *tracker, const char *symbol, long first, long final,
+                          long prev) {
+    market_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.event = MARKET_EVENT_DEPTH;
+    data.symbol = (char *)symbol;
+    data.first_update_id = first;
+    data.final_update_id = final;
+    data.prev_final_update_id = prev;
+    return seq_tracker_check(tracker, &data);
+}
+
+static void test_agg_trade(void) {
+    seq_tracker_t *tracker = seq_tracker_create(on_event, NULL);
+    event_count = 0;
+
+    CHECK(agg_trade(tracker, "BTCUSDT", 100, 1000, 1002) == SEQ_OK);
+    CHECK(agg_trade(tracker, "BTCUSDT", 101, 1003, 1003) == SEQ_OK);
+    CHECK(event_count == 0);
+
+    // Three aggregates missing
+    CHECK(agg_trade(tracker, "BTCUSDT", 105, 1010, 1011) == SEQ_GAP);
+    CHECK(event_count == 1);
+    CHECK(last_event.status == SEQ_GAP && last_event.type == SEQ_STREAM_AGG_TRADE);
+    CHECK(strcmp(last_event.symbol, "BTCUSDT") == 0);
+    CHECK(last_event.expected == 102 && last_event.received == 105 && last_event.missing == 3);
+
+    CHECK(agg_trade(tracker, "BTCUSDT", 105, 1010, 1011) == SEQ_DUPLICATE);
+    CHECK(last_event.status == SEQ_DUPLICATE && last_event.received == 105);
+    CHECK(agg_trade(tracker, "BTCUSDT", 103, 1006, 1007) == SEQ_REORDER);
+    CHECK(last_event.status == SEQ_REORDER && last_event.expected == 105);
+    CHECK(event_count == 3);
+
+    // A late or repeated message leaves the position of the stream alone
+    CHECK(agg_trade(tracker, "BTCUSDT", 106, 1012, 1015) == SEQ_OK);
+
+    // "a" continues but trades 1016..1019 are not covered by any aggregate
+    CHECK(agg_trade(tracker, "BTCUSDT", 107, 1020, 1020) == SEQ_TRADE_GAP);
+    CHECK(last_event.status == SEQ_TRADE_GAP);
+    CHECK(last_event.expected == 1016 && last_event.received == 1020 && last_event.missing == 4);
+
+    // Streams without "f"/"l" only have "a" checked
+    CHECK(agg_trade(tracker, "BTCUSDT", 108, 0, 0) == SEQ_OK);
+    CHECK(agg_trade(tracker, "BTCUSDT", 109, 0, 0) == SEQ_OK);
+
+    const seq_stream_t *stream = seq_tracker_find(tracker, "BTCUSDT", SEQ_STREAM_AGG_TRADE);
+    CHECK(stream != NULL);
+    CHECK(stream && stream->messages == 9);
+    CHECK(stream && stream->gaps == 1 && stream->missing == 3);
+    CHECK(stream && stream->duplicates == 1 && stream->reorders == 1);
+    CHECK(stream && stream->trade_gaps == 1 && stream->missing_trades == 4);
+
+    // Symbols are tracked apart
+    CHECK(agg_trade(tracker, "ETHUSDT", 5, 50, 50) == SEQ_OK);
+    CHECK(seq_tracker_find(tracker, "ETHUSDT", SEQ_STREAM_BOOK_TICKER) == NULL);
+    CHECK(tracker->stream_count == 2);
+
+    seq_tracker_destroy(tracker);
+}
+
+// Book ticker ids are shared with the depth stream, so only ordering is checked
+static void test_book_ticker(void) {
+    seq_tracker_t *tracker = seq_tracker_create(on_event, NULL);
+    event_count = 0;
+
+    CHECK(book_ticker(tracker, "BTCUSDT", 400) == SEQ_OK);
+    CHECK(book_ticker(tracker, "BTCUSDT", 420) == SEQ_OK);
+    CHECK(event_count == 0);
+    CHECK(book_ticker(tracker, "BTCUSDT", 420) == SEQ_DUPLICATE);
+    CHECK(book_ticker(tracker, "BTCUSDT", 410) == SEQ_REORDER);
+    CHECK(last_event.type == SEQ_STREAM_BOOK_TICKER && last_event.expected == 420);
+    CHECK(book_ticker(tracker, "BTCUSDT", 421) == SEQ_OK);
+    CHECK(event_count == 2);
+
+    seq_tracker_destroy(tracker);
+}
+
+static void test_depth(void) {
+    seq_tracker_t *tracker = seq_tracker_create(on_event, NULL);
+    event_count = 0;
+
+    // Futures: every diff names the final id of the one before
+    CHECK(depth(tracker, "BTCUSDT", 100, 110, 99) == SEQ_OK);
+    CHECK(depth(tracker, "BTCUSDT", 115, 120, 110) == SEQ_OK);
+    CHECK(depth(tracker, "BTCUSDT", 130, 140, 125) == SEQ_GAP);
+    CHECK(last_event.type == SEQ_STREAM_DEPTH);
+    CHECK(last_event.expected == 120 && last_event.received == 125 && last_event.missing == 0);
+    CHECK(depth(tracker, "BTCUSDT", 130, 140, 125) == SEQ_DUPLICATE);
+    CHECK(depth(tracker, "BTCUSDT", 121, 124, 120) == SEQ_REORDER);
+
+    // Spot: no "pu", "U" has to follow the previous "u"
+    CHECK(depth(tracker, "ETHUSDT", 10, 20, 0) == SEQ_OK);
+    CHECK(depth(tracker, "ETHUSDT", 21, 25, 0) == SEQ_OK);
+    CHECK(depth(tracker, "ETHUSDT", 31, 40, 0) == SEQ_GAP);
+    CHECK(last_event.expected == 26 && last_event.received == 31 && last_event.missing == 5);
+
+    const seq_stream_t *stream = seq_tracker_find(tracker, "ETHUSDT", SEQ_STREAM_DEPTH);
+    CHECK(stream && stream->gaps == 1 && stream->missing == 5);
+    CHECK(event_count == 4);
+
+    seq_tracker_destroy(tracker);
+}
+
+// After a reset the next message starts the stream over, counters are kept
+static void test_reset(void) {
+    seq_tracker_t *tracker = seq_tracker_create(on_event, NULL);
+    event_count = 0;
+
+    CHECK(agg_trade(tracker, "BTCUSDT", 100, 1000, 1000) == SEQ_OK);
+    CHECK(depth(tracker, "BTCUSDT", 10, 20, 0) == SEQ_OK);
+
+    seq_tracker_reset(tracker, "BTCUSDT", SEQ_STREAM_AGG_TRADE);
+    CHECK(agg_trade(tracker, "BTCUSDT", 50, 500, 500) == SEQ_OK);
+    CHECK(depth(tracker, "BTCUSDT", 40, 50, 0) == SEQ_GAP);
+
+    seq_tracker_reset_all(tracker);
+    CHECK(agg_trade(tracker, "BTCUSDT", 10, 10, 10) == SEQ_OK);
+    CHECK(depth(tracker, "BTCUSDT", 5, 8, 0) == SEQ_OK);
+    CHECK(event_count == 1);
+
+    const seq_stream_t *stream = seq_tracker_find(tracker, "BTCUSDT", SEQ_STREAM_AGG_TRADE);
+    CHECK(stream && stream->messages == 3 && stream->reorders == 0 && stream->trade_gaps == 0);
+
+    // Resetting an unknown stream is harmless
+    seq_tracker_reset(tracker, "SOLUSDT", SEQ_STREAM_DEPTH);
+    CHECK(seq_tracker_find(tracker, "SOLUSDT", SEQ_STREAM_DEPTH) == NULL);
+
+    seq_tracker_destroy(tracker);
+}
+
+// Events without sequence ids are not tracked
+static void test_untracked(void) {
+    seq_tracker_t *tracker = seq_tracker_create(NULL, NULL);
+
+    market_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.event = MARKET_EVENT_MARK_PRICE;
+    data.symbol = (char *)"BTCUSDT";
+    CHECK(seq_tracker_check(tracker, &data) == SEQ_UNTRACKED);
+    data.event = MARKET_EVENT_AGG_TRADE;
+    data.symbol = NULL;
+    CHECK(seq_tracker_check(tracker, &data) == SEQ_UNTRACKED);
+    CHECK(tracker->stream_count == 0);
+
+    seq_tracker_destroy(tracker);
+}
+
+int main(void) {
+    test_agg_trade();
+    test_book_ticker();
+    test_depth();
+    test_reset();
+    test_untracked();
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include "socket_tuning.h"
+#include "ws_client.h"
+#include "cryptostream.h"
+#include "mock_ws_server.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+#ifdef __linux__
+#include <linux/net_tstamp.h>
+#endif
+
+// Connected TCP pair over loopback, the same socket type the client tunes
+static int loopback_pair(int *client_fd, int *server_fd) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (struct sockaddr *)&addr, &addr_len) < 0) {
+        close(listener);
+        return -1;
+    }
+
+    *client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (*client_fd < 0 || connect(*client_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(listener);
+        return -1;
+    }
+    *server_fd = accept(listener, NULL, NULL);
+    close(listener);
+    return *server_fd < 0 ? -1 : 0;
+}
+
+static int get_int_option(int fd, int level, int name) {
+    int value = -1;
+    socklen_t len = sizeof(value);
+    if (getsockopt(fd, level, name, &value, &len) < 0) {
+        return -1;
+    }
+    return value;
+}
+
+static void test_options_read_back(void) {
+    int client_fd, server_fd;
+    CHECK(loopback_pair(&client_fd, &server_fd) == 0);
+
+    socket_tuning_t tuning;
+    memset(&tuning, 0, sizeof(tuning));
+    tuning.rcvbuf = 65536;
+    tuning.tcp_nodelay = true;
+    tuning.busy_poll_us = 50;
+    tuning.tcp_quickack = true;
+    tuning.rx_timestamping = true;
+
+    int applied = socket_tuning_apply(client_fd, &tuning);
+
+    CHECK(get_int_option(client_fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+    // The kernel doubles the request for bookkeeping overhead
+    CHECK(get_int_option(client_fd, SOL_SOCKET, SO_RCVBUF) >= tuning.rcvbuf);
+
+#ifdef SO_BUSY_POLL
+    // Raising busy polling above net.core.busy_read needs CAP_NET_ADMIN
+    int busy_poll = get_int_option(client_fd, SOL_SOCKET, SO_BUSY_POLL);
+    if (geteuid() == 0) {
+        CHECK(busy_poll == tuning.busy_poll_us);
+    } else if (busy_poll != tuning.busy_poll_us) {
+        printf("SO_BUSY_POLL not permitted without CAP_NET_ADMIN, skipped\n");
+    }
+#endif
+
+#ifdef SO_TIMESTAMPING
+    int flags = get_int_option(client_fd, SOL_SOCKET, SO_TIMESTAMPING);
+    CHECK(flags >= 0);
+    CHECK(flags & SOF_TIMESTAMPING_RX_SOFTWARE);
+    CHECK(flags & SOF_TIMESTAMPING_SOFTWARE);
+#endif
+
+    if (geteuid() == 0) {
+        CHECK(applied == 0);
+    }
+
+    // Re-arming after a receive must keep the socket usable
+    socket_tuning_rearm(client_fd, &tuning);
+    CHECK(get_int_option(client_fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+
+    close(client_fd);
+    close(server_fd);
+}
+
+static void test_defaults_untouched(void) {
+    int client_fd, server_fd;
+    CHECK(loopback_pair(&client_fd, &server_fd) == 0);
+
+    int rcvbuf = get_int_option(client_fd, SOL_SOCKET, SO_RCVBUF);
+    socket_tuning_t tuning;
+    memset(&tuning, 0, sizeof(tuning));
+
+    CHECK(socket_tuning_apply(client_fd, &tuning) == 0);
+    CHECK(get_int_option(client_fd, IPPROTO_TCP, TCP_NODELAY) == 0);
+    CHECK(get_int_option(client_fd, SOL_SOCKET, SO_RCVBUF) == rcvbuf);
+    CHECK(socket_tuning_apply(-1, &tuning) == -1);
+    CHECK(socket_tuning_apply(client_fd, NULL) == -1);
+
+    close(client_fd);
+    close(server_fd);
+}
+
+// Reads through the recvmsg BIO pick up the kernel receive timestamp
+static void test_rx_timestamp_bio(void) {
+#ifdef SO_TIMESTAMPING
+    int client_fd, server_fd;
+    CHECK(loopback_pair(&client_fd, &server_fd) == 0);
+
+    socket_tuning_t tuning;
+    memset(&tuning, 0, sizeof(tuning));
+    tuning.rx_timestamping = true;
+    CHECK(socket_tuning_apply(client_fd, &tuning) == 0);
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    SSL *ssl = ctx ? SSL_new(ctx) : NULL;
+    CHECK(ssl != NULL);
+    if (!ssl) {
+        SSL_CTX_free(ctx);
+        return;
+    }
+
+    int64_t stamp_ns = 0;
+    CHECK(socket_tuning_attach_rx_timestamps(ssl, client_fd, &stamp_ns) == 0);
+
+    int64_t before = socket_tuning_now_ns();
+    const char payload[] = "tick";
+    CHECK(write(server_fd, payload, sizeof(payload)) == (ssize_t)sizeof(payload));
+
+    char buffer[16];
+    int n = BIO_read(SSL_get_rbio(ssl), buffer, sizeof(buffer));
+    int64_t after = socket_tuning_now_ns();
+
+    CHECK(n == (int)sizeof(payload));
+    CHECK(memcmp(buffer, payload, sizeof(payload)) == 0);
+    CHECK(stamp_ns >= before && stamp_ns <= after);
+
+    SSL_free(ssl);
+    SSL_CTX_free(ctx);
+    close(client_fd);
+    close(server_fd);
+#endif
+}
+
+#define GREETING "{\"e\":\"aggTrade\",\"E\":1700000000000,\"s\":\"BTCUSDT\",\"a\":1," \
+                 "\"p\":\"100.5\",\"q\":\"1\",\"f\":1,\"l\":1,\"T\":1700000000000,\"m\":true}"
+
+static socket_tuning_t full_tuning(void) {
+    socket_tuning_t tuning;
+    memset(&tuning, 0, sizeof(tuning));
+    tuning.rcvbuf = 262144;
+    tuning.tcp_nodelay = true;
+    tuning.tcp_quickack = true;
+    tuning.rx_timestamping = true;
+    return tuning;
+}
+
+typedef struct {
+    ws_client_t *client;
+    int messages;
+    int64_t rx_timestamp_ns;
+    int64_t kernel_rx_ns;
+} client_probe_t;
+
+static void probe_message(void *user, const char *data, size_t len) {
+    (void)data;
+    (void)len;
+    client_probe_t *probe = (client_probe_t *)user;
+    probe->messages++;
+    probe->rx_timestamp_ns = ws_client_rx_timestamp(probe->client);
+    probe->kernel_rx_ns = probe->client->kernel_rx_ns;
+}
+
+// Options set through the connecting and established hooks are in effect on the
+// connected socket, and TLS reads go through the timestamping BIO
+static void test_client_connection(void) {
+    mock_ws_server_t server;
+    CHECK(mock_ws_start(&server, GREETING) == 0);
+
+    client_probe_t probe;
+    memset(&probe, 0, sizeof(probe));
+    socket_tuning_t tuning = full_tuning();
+    probe.client = ws_client_create("127.0.0.1", server.port, "/ws");
+    probe.client->user = &probe;
+    probe.client->on_message = probe_message;
+    ws_client_set_socket_tuning(probe.client, &tuning);
+
+    int64_t before = socket_tuning_now_ns();
+    CHECK(ws_client_connect(probe.client) == 0);
+    for (int i = 0; i < 200 && probe.messages == 0; i++) {
+        ws_client_service(probe.client, 10);
+    }
+    int64_t after = socket_tuning_now_ns();
+    CHECK(probe.messages == 1);
+
+    int fd = probe.client->wsi ? lws_get_socket_fd(probe.client->wsi) : -1;
+    CHECK(fd >= 0);
+    if (fd >= 0) {
+        CHECK(get_int_option(fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+        CHECK(get_int_option(fd, SOL_SOCKET, SO_RCVBUF) >= tuning.rcvbuf);
+#ifdef TCP_QUICKACK
+        // Re-armed after the receive, the kernel would have cleared it otherwise
+        CHECK(get_int_option(fd, IPPROTO_TCP, TCP_QUICKACK) == 1);
+#endif
+#ifdef SO_TIMESTAMPING
+        CHECK(get_int_option(fd, SOL_SOCKET, SO_TIMESTAMPING) & SOF_TIMESTAMPING_RX_SOFTWARE);
+#endif
+    }
+
+#ifdef SO_TIMESTAMPING
+    // The message carries the kernel stamp taken by recvmsg, not a user space clock read
+    CHECK(probe.kernel_rx_ns != 0);
+    CHECK(probe.rx_timestamp_ns == probe.kernel_rx_ns);
+#endif
+    CHECK(probe.rx_timestamp_ns >= before && probe.rx_timestamp_ns <= after);
+
+    ws_client_destroy(probe.client);
+    mock_ws_stop(&server);
+}
+
+typedef struct {
+    int events;
+    int64_t receive_time_ns;
+    long event_time;
+} stream_probe_t;
+
+static void probe_market_data(void *user, const market_data_t *data, const char *raw, size_t len) {
+    (void)raw;
+    (void)len;
+    stream_probe_t *probe = (stream_probe_t *)user;
+    probe->events++;
+    probe->receive_time_ns = data->receive_time_ns;
+    probe->event_time = data->event_time;
+}
+
+// The receive timestamp reaches parsed events through the embedding API
+static void test_stream_receive_time(void) {
+    mock_ws_server_t server;
+    CHECK(mock_ws_start(&server, GREETING) == 0);
+
+    stream_probe_t probe;
+    memset(&probe, 0, sizeof(probe));
+    socket_tuning_t tuning = full_tuning();
+    cryptostream_t *stream = cryptostream_create("127.0.0.1", server.port, "/ws");
+    cryptostream_callbacks_t callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.on_market_data = probe_market_data;
+    cryptostream_set_callbacks(stream, &callbacks, &probe);
+    cryptostream_set_socket_tuning(stream, &tuning);
+
+    int64_t before = socket_tuning_now_ns();
+    CHECK(cryptostream_connect(stream) == 0);
+    for (int i = 0; i < 200 && probe.events == 0; i++) {
+        cryptostream_poll(stream, 10);
+    }
+    int64_t after = socket_tuning_now_ns();
+
+    CHECK(probe.events == 1);
+    CHECK(probe.event_time == 1700000000000L);
+    CHECK(probe.receive_time_ns >= before && probe.receive_time_ns <= after);
+
+    cryptostream_destroy(stream);
+    mock_ws_stop(&server);
+}
+
+int main(void) {
+    test_options_read_back();
+    test_defaults_untouched();
+    test_rx_timestamp_bio();
+    test_client_connection();
+    test_stream_receive_time();
+    return TEST_RESULT();
+}
\ No newline at end of file
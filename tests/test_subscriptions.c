@@ -0,0 +1,156 @@
+#include "cryptostream.h"
+#include "ws_client.h"
+#include "mock_ws_server.h"
+#include "test_util.h"
+
+static mock_ws_server_t server;
+
+// Service until the server has seen count client frames, false after two seconds
+static bool service_until_frames(ws_client_t *client, int count) {
+    for (int i = 0; i < 200; i++) {
+        if (mock_ws_frame_count(&server) >= count) {
+            return true;
+        }
+        ws_client_service(client, 10);
+    }
+    return false;
+}
+
+static bool service_until_connected(ws_client_t *client) {
+    for (int i = 0; i < 200 && !client->connected; i++) {
+        ws_client_service(client, 10);
+    }
+    return client->connected;
+}
+
+static bool frame_is(int index, const char *expected) {
+    char *frame = mock_ws_frame(&server, index);
+    bool same = frame && strcmp(frame, expected) == 0;
+    if (!same) {
+        fprintf(stderr, "frame %d: %s, expected %s\n", index, frame ? frame : "(none)", expected);
+    }
+    free(frame);
+    return same;
+}
+
+// Only the difference to the held set goes out, one frame per direction
+static void test_update_sends_difference(void) {
+    ws_client_t *client = ws_client_create("127.0.0.1", server.port, "/ws");
+    CHECK(ws_client_connect(client) == 0);
+    CHECK(service_until_connected(client));
+
+    const char *first[] = {"btcusdt@aggTrade", "btcusdt@bookTicker", "ethusdt@aggTrade"};
+    CHECK(ws_client_update_subscriptions(client, first, 3) == 0);
+    CHECK(service_until_frames(client, 1));
+    CHECK(frame_is(0, "{\"method\":\"SUBSCRIBE\",\"params\":[\"btcusdt@aggTrade\","
+                      "\"btcusdt@bookTicker\",\"ethusdt@aggTrade\"],\"id\":1}"));
+    CHECK(client->subscription_count == 3);
+
+    const char *second[] = {"ethusdt@aggTrade", "btcusdt@bookTicker", "btcusdt@depth@100ms",
+                            "btcusdt@depth@100ms"};
+    CHECK(ws_client_update_subscriptions(client, second, 4) == 0);
+    CHECK(service_until_frames(client, 3));
+    CHECK(frame_is(1, "{\"method\":\"UNSUBSCRIBE\",\"params\":[\"btcusdt@aggTrade\"],\"id\":2}"));
+    CHECK(frame_is(2, "{\"method\":\"SUBSCRIBE\",\"params\":[\"btcusdt@depth@100ms\"],\"id\":3}"));
+    CHECK(client->subscription_count == 3);
+
+    // Same set again: nothing is sent
+    CHECK(ws_client_update_subscriptions(client, second, 3) == 0);
+    for (int i = 0; i < 10; i++) {
+        ws_client_service(client, 10);
+    }
+    CHECK(mock_ws_frame_count(&server) == 3);
+
+    ws_client_destroy(client);
+}
+
+// MAX_SUBSCRIPTIONS streams fit in one frame, adding to a full set fails
+static void test_subscription_limit(void) {
+    int before = mock_ws_frame_count(&server);
+    ws_client_t *client = ws_client_create("127.0.0.1", server.port, "/ws");
+    CHECK(ws_client_connect(client) == 0);
+    CHECK(service_until_connected(client));
+
+    char names[MAX_SUBSCRIPTIONS][32];
+    const char *streams[MAX_SUBSCRIPTIONS];
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; i++) {
+        snprintf(names[i], sizeof(names[i]), "sym%03d@aggTrade", i);
+        streams[i] = names[i];
+    }
+    CHECK(ws_client_update_subscriptions(client, streams, MAX_SUBSCRIPTIONS) == 0);
+    CHECK(service_until_frames(client, before + 1));
+    CHECK(client->subscription_count == MAX_SUBSCRIPTIONS);
+
+    char *frame = mock_ws_frame(&server, before);
+    CHECK(frame && strstr(frame, "\"sym000@aggTrade\"") && strstr(frame, "\"sym199@aggTrade\""));
+    free(frame);
+
+    CHECK(ws_client_subscribe(client, "one@toomany") == -1);
+    CHECK(client->subscription_count == MAX_SUBSCRIPTIONS);
+
+    ws_client_destroy(client);
+}
+
+static int connects = 0;
+static int disconnects = 0;
+
+static void count_connect(void *user) {
+    (void)user;
+    connects++;
+}
+
+static void count_disconnect(void *user) {
+    (void)user;
+    disconnects++;
+}
+
+// After the server drops the connection the stream reconnects and subscribes the whole set
+static void test_reconnect_resubscribes(void) {
+    cryptostream_t *stream = cryptostream_create("127.0.0.1", server.port, "/ws");
+    cryptostream_callbacks_t callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.on_connect = count_connect;
+    callbacks.on_disconnect = count_disconnect;
+    cryptostream_set_callbacks(stream, &callbacks, NULL);
+    cryptostream_set_reconnect(stream, 20, 100);
+
+    const char *streams[] = {"btcusdt@aggTrade", "ethusdt@bookTicker"};
+    CHECK(cryptostream_set_streams(stream, streams, 2) == 0);
+    int before = mock_ws_frame_count(&server);
+    int connections = atomic_load(&server.connections);
+    CHECK(cryptostream_connect(stream) == 0);
+    for (int i = 0; i < 200 && mock_ws_frame_count(&server) < before + 1; i++) {
+        cryptostream_poll(stream, 10);
+    }
+    CHECK(frame_is(before, "{\"method\":\"SUBSCRIBE\",\"params\":[\"btcusdt@aggTrade\","
+                           "\"ethusdt@bookTicker\"],\"id\":1}"));
+
+    atomic_store(&server.drop, true);
+    for (int i = 0; i < 300 && mock_ws_frame_count(&server) < before + 2; i++) {
+        cryptostream_poll(stream, 10);
+    }
+    CHECK(atomic_load(&server.connections) == connections + 2);
+    CHECK(connects == 2 && disconnects == 1);
+    CHECK(cryptostream_connected(stream));
+    CHECK(frame_is(before + 1, "{\"method\":\"SUBSCRIBE\",\"params\":[\"btcusdt@aggTrade\","
+                               "\"ethusdt@bookTicker\"],\"id\":2}"));
+
+    // Stopped streams stay down
+    cryptostream_stop(stream);
+    CHECK(cryptostream_poll(stream, 10) == -1);
+    cryptostream_destroy(stream);
+}
+
+int main(void) {
+    if (mock_ws_start(&server, NULL) < 0) {
+        fprintf(stderr, "Failed to start mock WebSocket server\n");
+        return 1;
+    }
+
+    test_update_sends_difference();
+    test_subscription_limit();
+    test_reconnect_resubscribes();
+
+    mock_ws_stop(&server);
+    return TEST_RESULT();
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tick_store.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ftw.h>
+
+#define DAY_MS 86400000LL
+#define BASE_TS (19723LL * DAY_MS + 3600000LL)   // 2024-01-01 01:00 UTC
+
+typedef struct {
+    int64_t rows;
+    int64_t first_ts;
+    int64_t last_ts;
+    double price_sum;
+    double quantity_sum;
+    int sides[4];
+    bool ordered;
+} query_result_t;
+
+static void collect(const tick_batch_t *batch, void *ctx) {
+    query_result_t *result = (query_result_t *)ctx;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (result->rows == 0) {
+            result->first_ts = batch->timestamp[i];
+        } else if (batch->timestamp[i] < result->last_ts) {
+            result->ordered = false;
+        }
+        result->last_ts = batch->timestamp[i];
+        result->price_sum += batch->price[i];
+        result->quantity_sum += batch->quantity[i];
+        result->sides[batch->side[i] & 3]++;
+        result->rows++;
+    }
+}
+
+static int64_t query(const char *root, const char *symbol, tick_kind_t kind, int64_t t0, int64_t t1,
+                     query_result_t *result) {
+    memset(result, 0, sizeof(*result));
+    result->ordered = true;
+    return tick_store_query(root, symbol, kind, t0, t1, collect, result);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+// Rows with timestamp t0 at the end of one block and the start of the next
+static void test_block_boundary(const char *root) {
+    tick_store_t *store = tick_store_open(root);
+    CHECK(store != NULL);
+    if (!store) {
+        return;
+    }
+
+    int64_t t0 = BASE_TS + 5000;
+    int rows = TICK_STORE_BLOCK_ROWS * 3;
+    int at_t0 = 0;
+    for (int i = 0; i < rows; i++) {
+        // Last 4 rows of block 0 and the first 3 of block 1 share t0
+        int64_t ts;
+        if (i < TICK_STORE_BLOCK_ROWS - 4) {
+            ts = BASE_TS + i;
+        } else if (i < TICK_STORE_BLOCK_ROWS + 3) {
+            ts = t0;
+            at_t0++;
+        } else {
+            ts = t0 + i;
+        }
+        tick_t tick = { ts, 100.0 + (i % 7) * 0.01, 0.001 * (i + 1), (i & 1) ? TICK_SIDE_SELL : TICK_SIDE_BUY };
+        CHECK(tick_store_append(store, "BTCUSDT", TICK_KIND_TRADE, &tick) == 0);
+    }
+    CHECK(tick_store_sync(store) == 0);
+
+    // Readable while the writer still has the segment open
+    query_result_t result;
+    CHECK(query(root, "BTCUSDT", TICK_KIND_TRADE, t0, t0, &result) == at_t0);
+    CHECK(result.rows == at_t0);
+    CHECK(result.first_ts == t0 && result.last_ts == t0);
+
+    tick_store_close(store);
+
+    // Full range round trip after close
+    double price_sum = 0.0, quantity_sum = 0.0;
+    for (int i = 0; i < rows; i++) {
+        price_sum += 100.0 + (i % 7) * 0.01;
+        quantity_sum += 0.001 * (i + 1);
+    }
+    CHECK(query(root, "BTCUSDT", TICK_KIND_TRADE, BASE_TS, BASE_TS + DAY_MS / 2, &result) == rows);
+    CHECK(result.ordered);
+    CHECK(result.first_ts == BASE_TS);
+    CHECK(result.last_ts == t0 + rows - 1);
+    CHECK(result.sides[TICK_SIDE_BUY] == rows / 2 && result.sides[TICK_SIDE_SELL] == rows / 2);
+    CHECK(result.price_sum > price_sum - 1e-6 && result.price_sum < price_sum + 1e-6);
+    CHECK(result.quantity_sum > quantity_sum - 1e-6 && result.quantity_sum < quantity_sum + 1e-6);
+
+    // Range starting inside a block and ending before the last row
+    CHECK(query(root, "BTCUSDT", TICK_KIND_TRADE, BASE_TS + 10, t0 - 1, &result) ==
+          TICK_STORE_BLOCK_ROWS - 4 - 10);
+
+    // Nothing stored for the range, symbol or kind
+    CHECK(query(root, "BTCUSDT", TICK_KIND_TRADE, BASE_TS - 1000, BASE_TS - 1, &result) == 0);
+    CHECK(query(root, "ETHUSDT", TICK_KIND_TRADE, BASE_TS, t0, &result) == 0);
+    CHECK(query(root, "BTCUSDT", TICK_KIND_QUOTE, BASE_TS, t0, &result) == 0);
+    CHECK(query(root, "BTCUSDT", TICK_KIND_TRADE, t0, t0 - 1, &result) == -1);
+}
+
+// Quotes across a UTC day boundary land in two segments and reappend after reopening
+static void test_day_rollover(const char *root) {
+    tick_store_t *store = tick_store_open(root);
+    CHECK(store != NULL);
+    if (!store) {
+        return;
+    }
+
+    int64_t midnight = (BASE_TS / DAY_MS + 1) * DAY_MS;
+    market_data_t quote;
+    memset(&quote, 0, sizeof(quote));
+    double bid_price = 2000.5, bid_quantity = 3.0, ask_price = 2000.6, ask_quantity = 4.0;
+    quote.event = MARKET_EVENT_BOOK_TICKER;
+    quote.symbol = "ETHUSDT";
+    quote.bid_prices = &bid_price;
+    quote.bid_quantities = &bid_quantity;
+    quote.ask_prices = &ask_price;
+    quote.ask_quantities = &ask_quantity;
+    quote.bid_count = 1;
+    quote.ask_count = 1;
+
+    for (int64_t ts = midnight - 10; ts < midnight + 10; ts++) {
+        quote.timestamp = ts;
+        CHECK(tick_store_append_market_data(store, &quote) == 0);
+    }
+    tick_store_close(store);
+
+    // Reopening continues the existing segment
+    store = tick_store_open(root);
+    CHECK(store != NULL);
+    quote.timestamp = midnight + 10;
+    CHECK(tick_store_append_market_data(store, &quote) == 0);
+    tick_store_close(store);
+
+    query_result_t result;
+    CHECK(query(root, "ETHUSDT", TICK_KIND_QUOTE, midnight - 10, midnight + 10, &result) == 42);
+    CHECK(result.ordered);
+    CHECK(result.sides[TICK_SIDE_BID] == 21 && result.sides[TICK_SIDE_ASK] == 21);
+    CHECK(query(root, "ETHUSDT", TICK_KIND_QUOTE, midnight, midnight, &result) == 2);
+    CHECK(query(root, "ETHUSDT", TICK_KIND_QUOTE, midnight - 1, midnight - 1, &result) == 2);
+}
+
+int main(void) {
+    char root[] = "/tmp/tick_store_test.XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    test_block_boundary(root);
+    test_day_rollover(root);
+
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return TEST_RESULT();
+}
\ No newline at end of file